@@ -0,0 +1,62 @@
+#include "RA8876.h"
+
+#define RA8876_CS        12
+#define RA8876_RESET     11
+#define RA8876_BACKLIGHT 10
+
+RA8876 tft = RA8876(RA8876_CS, RA8876_RESET);
+
+void setup()
+{
+  Serial.begin(9600);
+
+  delay(1000);
+
+  while (!Serial && (millis() < 5000));
+
+  Serial.println("Initializing display...");
+
+  pinMode(RA8876_BACKLIGHT, OUTPUT);  // Set backlight pin to OUTPUT mode
+  digitalWrite(RA8876_BACKLIGHT, HIGH);  // Turn on backlight
+
+  if (!tft.init())
+  {
+    Serial.println("Could not initialize RA8876");
+  }
+
+  // Three pages, so drawing can carry on while a finished frame waits for VSYNC
+  if (!tft.initPages(3))
+  {
+    Serial.println("Could not set up pages");
+  }
+
+  Serial.println("Display init completed.");
+}
+
+// Draws a simple gauge with its needle at the given angle (radians).
+void drawGauge(float angle)
+{
+  int cx = tft.getWidth() / 2;
+  int cy = tft.getHeight() / 2;
+  int radius = tft.getHeight() / 3;
+
+  tft.fillRect(0, 0, tft.getWidth(), tft.getHeight(), 0);
+  tft.fillCircle(cx, cy, radius, RGB565(40, 40, 40));
+  tft.drawCircle(cx, cy, radius, RGB565(255, 255, 255));
+  tft.drawLine(cx, cy, cx + (cos(angle) * radius), cy - (sin(angle) * radius), RGB565(255, 0, 0));
+}
+
+void loop()
+{
+  for (int i = 0; i < 360; i++)
+  {
+    float angle = ((sin(i * (PI / 180.0)) + 1) / 2.0) * PI;
+
+    drawGauge(angle);  // Lands on the hidden back page
+
+    // Queue the finished page, then poll for VSYNC until it is on screen. Other work
+    //  could be done between polls.
+    tft.requestFlip();
+    while (!tft.updateFlip());
+  }
+}
@@ -0,0 +1,159 @@
+#include <Arduino.h>
+#include <SPI.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "RA8876Emulator.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+static uint64_t nowNs = 0;
+static uint8_t pinState[256];
+
+uint64_t hostNanos(void)
+{
+  return nowNs;
+}
+
+void hostAdvance(uint64_t ns)
+{
+  nowNs += ns;
+}
+
+void hostDrivePin(int pin, int value)
+{
+  pinState[pin & 0xFF] = value;
+}
+
+void pinMode(int pin, int mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+void digitalWrite(int pin, int value)
+{
+  pinState[pin & 0xFF] = value;
+
+  RA8876Emulator *emu = RA8876Emulator::attached();
+  if (emu)
+    emu->pinChanged(pin, value);
+}
+
+int digitalRead(int pin)
+{
+  return pinState[pin & 0xFF];
+}
+
+void delay(unsigned long ms)
+{
+  hostAdvance((uint64_t) ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  hostAdvance((uint64_t) us * 1000);
+}
+
+unsigned long millis(void)
+{
+  return nowNs / 1000000;
+}
+
+unsigned long micros(void)
+{
+  return nowNs / 1000;
+}
+
+long random(long max)
+{
+  return (max > 0) ? (rand() % max) : 0;
+}
+
+long random(long min, long max)
+{
+  return (max > min) ? (min + random(max - min)) : min;
+}
+
+//
+// Print
+//
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+
+  return n;
+}
+
+size_t Print::printNumber(unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char *p = &buf[sizeof(buf) - 1];
+
+  if (base < 2)
+    base = 10;
+
+  *p = '\0';
+  do
+  {
+    int digit = n % base;
+    *--p = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+    n /= base;
+  } while (n);
+
+  return write(p);
+}
+
+size_t Print::print(long n, int base)
+{
+  if ((base == DEC) && (n < 0))
+    return print('-') + printNumber(-(unsigned long) n, base);
+
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+
+  return write(buf);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return fwrite(&c, 1, 1, stdout);
+}
+
+//
+// SPI
+//
+
+uint8_t SPIClass::transfer(uint8_t x)
+{
+  hostAdvance(8000000000ULL / m_clock);
+
+  RA8876Emulator *emu = RA8876Emulator::attached();
+  return emu ? emu->spiTransfer(x) : 0xFF;
+}
+
+uint16_t SPIClass::transfer16(uint16_t x)
+{
+  uint16_t hi = transfer(x >> 8);
+  return (hi << 8) | transfer(x & 0xFF);
+}
+
+void SPIClass::transfer(void *buf, size_t count)
+{
+  uint8_t *p = (uint8_t *) buf;
+  while (count--)
+  {
+    *p = transfer(*p);
+    p++;
+  }
+}
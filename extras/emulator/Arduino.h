@@ -0,0 +1,94 @@
+// Minimal host-side stand-in for the Arduino core, just enough to build the RA8876
+//  library on a desktop machine against RA8876Emulator. See README.md.
+// Time is virtual: it only advances when delay() is called or when bytes are
+//  clocked over the emulated bus, so timings are repeatable from run to run.
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT  0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Templates rather than the classic macros, so that standard headers included later
+//  still compile.
+template <class T, class L> inline T min(const T &a, const L &b) { return (b < a) ? b : a; }
+template <class T, class L> inline T max(const T &a, const L &b) { return (a < b) ? b : a; }
+
+typedef uint8_t byte;
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+
+long random(long max);
+long random(long min, long max);
+
+// Host-only: virtual clock in nanoseconds.
+uint64_t hostNanos(void);
+void hostAdvance(uint64_t ns);
+
+// Host-only: sets the level digitalRead() sees on a pin, as a device driving it would.
+void hostDrivePin(int pin, int value);
+
+class Print
+{
+private:
+  size_t printNumber(unsigned long n, int base);
+
+public:
+  virtual ~Print() {};
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *) str, strlen(str)) : 0; };
+
+  size_t print(const char *s) { return write(s); };
+  size_t print(char c) { return write((uint8_t) c); };
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); };
+  size_t print(int n, int base = DEC) { return print((long) n, base); };
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); };
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); };
+  size_t print(double n, int digits = 2);
+
+  size_t println(void) { return write("\r\n"); };
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); };
+  template <typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); };
+};
+
+class HardwareSerial : public Print
+{
+public:
+  void begin(unsigned long baud) { (void) baud; };
+  operator bool() { return true; };
+
+  using Print::write;
+  virtual size_t write(uint8_t c);
+};
+
+extern HardwareSerial Serial;
+
+#endif
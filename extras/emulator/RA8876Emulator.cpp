@@ -0,0 +1,1238 @@
+#include "RA8876Emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <RA8876.h>
+
+// Status register bits, data sheet section 19.1.
+#define STATUS_WRITE_FIFO_FULL  0x80
+#define STATUS_WRITE_FIFO_EMPTY 0x40
+#define STATUS_READ_FIFO_FULL   0x20
+#define STATUS_READ_FIFO_EMPTY  0x10
+#define STATUS_CORE_BUSY        0x08
+#define STATUS_SDRAM_READY      0x04
+
+// Time taken by one parallel bus cycle made with digitalWrite() calls.
+#define GPIO_CYCLE_NS 2000
+
+static RA8876Emulator *attachedEmulator = 0;
+
+RA8876EmulatorStats operator-(const RA8876EmulatorStats &a, const RA8876EmulatorStats &b)
+{
+  RA8876EmulatorStats d;
+
+  d.busCycles      = a.busCycles - b.busCycles;
+  d.busBytes       = a.busBytes - b.busBytes;
+  d.csAssertions   = a.csAssertions - b.csAssertions;
+  d.cmdWrites      = a.cmdWrites - b.cmdWrites;
+  d.dataWrites     = a.dataWrites - b.dataWrites;
+  d.dataReads      = a.dataReads - b.dataReads;
+  d.statusReads    = a.statusReads - b.statusReads;
+  d.memoryWrites   = a.memoryWrites - b.memoryWrites;
+  d.shapes         = a.shapes - b.shapes;
+  d.blits          = a.blits - b.blits;
+  d.chars          = a.chars - b.chars;
+  d.fifoOverflows  = a.fifoOverflows - b.fifoOverflows;
+  d.busyViolations = a.busyViolations - b.busyViolations;
+  d.tearingWrites  = a.tearingWrites - b.tearingWrites;
+  d.deselectedCycles = a.deselectedCycles - b.deselectedCycles;
+
+  return d;
+}
+
+RA8876Emulator::RA8876Emulator()
+{
+  m_csPin    = -1;
+  m_resetPin = -1;
+  m_parallel = false;
+
+  m_fifoDepth = 16;
+  m_pixelNs   = 10;
+  m_writeNs   = 20;
+  m_busTime   = 0;
+
+  m_frameNs = 16666667;  // 60Hz
+  m_blankNs = 1000000;
+
+  hardReset();
+  resetStats();
+}
+
+RA8876Emulator::~RA8876Emulator()
+{
+  if (attachedEmulator == this)
+    attachedEmulator = 0;
+}
+
+void RA8876Emulator::attachSpi(int csPin, int resetPin)
+{
+  m_csPin    = csPin;
+  m_resetPin = resetPin;
+
+  attachedEmulator = this;
+}
+
+void RA8876Emulator::attachParallel(enum ParallelBusMode mode, int width, const int *dataPins, int csPin, int a0Pin, int strobePin, int readPin, int resetPin)
+{
+  m_parallel  = true;
+  m_busMode   = mode;
+  m_busWidth  = (width == 16) ? 16 : 8;
+  for (int i = 0; i < m_busWidth; i++)
+    m_dataPins[i] = dataPins[i];
+  m_a0Pin     = a0Pin;
+  m_strobePin = strobePin;
+  m_readPin   = readPin;
+
+  // Idle levels: WR# and RD# high, or E low and R/W# low
+  m_strobeLevel = (mode == RA8876_BUS_8080) ? HIGH : LOW;
+  m_readLevel   = m_strobeLevel;
+
+  m_csPin    = csPin;
+  m_resetPin = resetPin;
+
+  attachedEmulator = this;
+}
+
+RA8876Emulator *RA8876Emulator::attached(void)
+{
+  return attachedEmulator;
+}
+
+void RA8876Emulator::hardReset(void)
+{
+  memset(m_regs, 0, sizeof(m_regs));
+  memset(m_pipRegs, 0, sizeof(m_pipRegs));
+  m_addr = 0;
+
+  m_sdram.clear();
+
+  m_csActive      = false;
+  m_haveCycleType = false;
+  m_cycleType     = 0;
+
+  m_pixelBytes = 0;
+  m_readDummy  = true;
+
+  m_haveTextLead = false;
+
+  m_busyUntil = 0;
+  m_fifo.clear();
+
+  m_vsyncCleared = busTime() / m_frameNs;
+}
+
+void RA8876Emulator::resetStats(void)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void RA8876Emulator::pinChanged(int pin, int value)
+{
+  if (pin == m_csPin)
+  {
+    if (value == LOW)
+      csAssert();
+    else
+      csRelease();
+  }
+  else if ((pin == m_resetPin) && (value == LOW))
+  {
+    hardReset();
+  }
+  else if (m_parallel)
+  {
+    parallelPinChanged(pin, value);
+  }
+}
+
+// 8080: data is latched as WR# rises, and driven while RD# is low. 6800: with R/W# low
+//  data is latched as E falls; with R/W# high it is driven while E is high.
+void RA8876Emulator::parallelPinChanged(int pin, int value)
+{
+  if (pin == m_strobePin)
+  {
+    bool rising  = value && !m_strobeLevel;
+    bool falling = !value && m_strobeLevel;
+    m_strobeLevel = value;
+
+    if (m_busMode == RA8876_BUS_8080)
+    {
+      if (rising)
+        parallelWrite();
+    }
+    else if (m_readLevel)
+    {
+      if (rising)
+        parallelRead();
+    }
+    else if (falling)
+    {
+      parallelWrite();
+    }
+  }
+  else if (pin == m_readPin)
+  {
+    bool falling = !value && m_readLevel;
+    m_readLevel = value;
+
+    if ((m_busMode == RA8876_BUS_8080) && falling)
+      parallelRead();
+  }
+}
+
+void RA8876Emulator::parallelWrite(void)
+{
+  hostAdvance(GPIO_CYCLE_NS);
+  countBusCycle(m_busWidth / 8);
+  if (!selected())
+    return;
+
+  uint16_t x = 0;
+  for (int i = 0; i < m_busWidth; i++)
+    x |= (digitalRead(m_dataPins[i]) ? 1 : 0) << i;
+
+  if (!digitalRead(m_a0Pin))
+    busCmdWrite(x & 0xFF);
+  else if (m_busWidth == 16)
+    busDataWrite16(x);
+  else
+    busDataWrite(x & 0xFF);
+}
+
+void RA8876Emulator::parallelRead(void)
+{
+  hostAdvance(GPIO_CYCLE_NS);
+  countBusCycle(m_busWidth / 8);
+
+  uint16_t x;
+  if (!selected())
+    x = 0xFFFF;
+  else if (!digitalRead(m_a0Pin))
+    x = busStatusRead();
+  else if (m_busWidth == 16)
+    x = busDataRead16();
+  else
+    x = busDataRead();
+
+  for (int i = 0; i < m_busWidth; i++)
+    hostDrivePin(m_dataPins[i], (x >> i) & 1);
+}
+
+void RA8876Emulator::csAssert(void)
+{
+  if (m_csActive)
+    return;
+
+  m_csActive = true;
+  m_haveCycleType = false;
+  m_stats.csAssertions++;
+}
+
+void RA8876Emulator::csRelease(void)
+{
+  m_csActive = false;
+  m_haveCycleType = false;
+}
+
+bool RA8876Emulator::selected(void)
+{
+  if (!m_csActive)
+    m_stats.deselectedCycles++;
+
+  return m_csActive;
+}
+
+// The first byte of each SPI frame selects the cycle type (A0 and WR# in bits 7 and 6).
+//  Every following byte in the same frame is a cycle of that type.
+uint8_t RA8876Emulator::spiTransfer(uint8_t x)
+{
+  m_stats.busCycles++;
+  m_stats.busBytes++;
+
+  if (!selected())
+    return 0xFF;
+
+  if (!m_haveCycleType)
+  {
+    m_cycleType = x & 0xC0;
+    m_haveCycleType = true;
+    return 0xFF;
+  }
+
+  switch (m_cycleType)
+  {
+  case RA8876_CMD_WRITE:
+    busCmdWrite(x);
+    return 0xFF;
+  case RA8876_DATA_WRITE:
+    busDataWrite(x);
+    return 0xFF;
+  case RA8876_DATA_READ:
+    return busDataRead();
+  default:
+    return busStatusRead();
+  }
+}
+
+void RA8876Emulator::busCmdWrite(uint8_t x)
+{
+  m_stats.cmdWrites++;
+
+  // Reselecting MRWDP does not discard a partially written pixel, which drawPixel()
+  //  relies on when it writes the two bytes of a pixel with separate writeReg() calls.
+  m_addr = x;
+}
+
+void RA8876Emulator::busDataWrite(uint8_t x)
+{
+  m_stats.dataWrites++;
+
+  if (m_addr == RA8876_REG_MRWDP)
+  {
+    m_stats.memoryWrites++;
+
+    // Data written to a full FIFO is lost, as on the chip
+    if (fifoLevel() >= m_fifoDepth)
+    {
+      m_stats.fifoOverflows++;
+      return;
+    }
+
+    if (m_regs[RA8876_REG_ICR] & 0x04)
+      textWrite(x);
+    else
+      memoryWrite(x);
+  }
+  else
+  {
+    writeRegister(m_addr, x);
+  }
+}
+
+// A data cycle on a 16-bit bus. Register writes only use the low byte; memory writes
+//  take both bytes, low byte first, as one FIFO entry.
+void RA8876Emulator::busDataWrite16(uint16_t x)
+{
+  if ((m_addr != RA8876_REG_MRWDP) || (m_regs[RA8876_REG_ICR] & 0x04))
+  {
+    busDataWrite(x & 0xFF);
+    return;
+  }
+
+  m_stats.dataWrites++;
+  m_stats.memoryWrites++;
+
+  if (fifoLevel() >= m_fifoDepth)
+  {
+    m_stats.fifoOverflows++;
+    return;
+  }
+
+  memoryWrite(x & 0xFF);
+  m_fifo.pop_back();
+  memoryWrite(x >> 8);
+}
+
+uint8_t RA8876Emulator::busDataRead(void)
+{
+  m_stats.dataReads++;
+
+  if (m_addr == RA8876_REG_MRWDP)
+    return memoryRead();
+
+  return readRegister(m_addr);
+}
+
+// A data read cycle on a 16-bit bus. Register reads only give the low byte; a memory
+//  read gives a whole 8 or 16 bpp pixel.
+uint16_t RA8876Emulator::busDataRead16(void)
+{
+  if ((m_addr != RA8876_REG_MRWDP) || m_readDummy || (canvasBpp() < 2))
+    return busDataRead();
+
+  m_stats.dataReads++;
+
+  uint16_t x = memoryRead();
+  return x | (memoryRead() << 8);
+}
+
+uint8_t RA8876Emulator::busStatusRead(void)
+{
+  m_stats.statusReads++;
+
+  uint8_t status = STATUS_READ_FIFO_EMPTY;
+
+  int level = fifoLevel();
+  if (level >= m_fifoDepth)
+    status |= STATUS_WRITE_FIFO_FULL;
+  else if (level == 0)
+    status |= STATUS_WRITE_FIFO_EMPTY;
+
+  if (engineBusy())
+    status |= STATUS_CORE_BUSY;
+
+  if (!m_sdram.empty())
+    status |= STATUS_SDRAM_READY;
+
+  return status;
+}
+
+uint64_t RA8876Emulator::busTime(void) const
+{
+  return m_busTime ? m_busTime : hostNanos();
+}
+
+bool RA8876Emulator::engineBusy(void) const
+{
+  return busTime() < m_busyUntil;
+}
+
+// Returns the number of memory writes still waiting in the FIFO.
+int RA8876Emulator::fifoLevel(void)
+{
+  uint64_t now = busTime();
+
+  size_t i = 0;
+  while ((i < m_fifo.size()) && (m_fifo[i] <= now))
+    i++;
+
+  m_fifo.erase(m_fifo.begin(), m_fifo.begin() + i);
+
+  return m_fifo.size();
+}
+
+// Queues one memory write that will take 'cost' nanoseconds to retire once it
+//  reaches the head of the FIFO.
+void RA8876Emulator::fifoPush(uint64_t cost)
+{
+  uint64_t start = busTime();
+  if (!m_fifo.empty() && (m_fifo.back() > start))
+    start = m_fifo.back();
+
+  m_fifo.push_back(start + cost);
+}
+
+void RA8876Emulator::writeRegister(uint8_t reg, uint8_t v)
+{
+  // The data sheet forbids touching the engine registers while a task is running
+  if (engineBusy() && (((reg >= RA8876_REG_CVSSA0) && (reg <= RA8876_REG_DEVR1)) ||
+                       ((reg >= RA8876_REG_BTE_CTRL0) && (reg <= RA8876_REG_APB_CTRL)) ||
+                       ((reg >= RA8876_REG_FGCR) && (reg <= RA8876_REG_FGCB))))
+    m_stats.busyViolations++;
+
+  m_regs[reg] = v;
+
+  if ((reg >= RA8876_REG_PWDULX0) && (reg <= RA8876_REG_PWH1))
+    m_pipRegs[(m_regs[RA8876_REG_MPWCTR] >> 4) & 1][reg - RA8876_REG_PWDULX0] = v;
+
+  switch (reg)
+  {
+  case RA8876_REG_SRR:
+    if (v & 0x01)
+    {
+      // Soft reset only resets the state machine
+      m_busyUntil = 0;
+      m_fifo.clear();
+      m_regs[reg] = 0;
+    }
+    break;
+  case RA8876_REG_INTF:
+    // Flags are cleared by writing 1; only VSYNC is modelled
+    m_regs[reg] = 0;
+    if (v & 0x10)
+      m_vsyncCleared = busTime() / m_frameNs;
+    break;
+  case RA8876_REG_MISA0:
+  case RA8876_REG_MISA1:
+  case RA8876_REG_MISA2:
+  case RA8876_REG_MISA3:
+    if ((busTime() % m_frameNs) >= m_blankNs)
+      m_stats.tearingWrites++;
+    break;
+  case RA8876_REG_CURH0:
+  case RA8876_REG_CURH1:
+  case RA8876_REG_CURV0:
+  case RA8876_REG_CURV1:
+    m_pixelBytes = 0;
+    m_readDummy = true;
+    break;
+  case RA8876_REG_DCR0:
+    if (v & 0x80)
+      startDcr0(v);
+    break;
+  case RA8876_REG_DCR1:
+    if (v & 0x80)
+      startDcr1(v);
+    break;
+  case RA8876_REG_BTE_CTRL0:
+    if (v & 0x10)
+      startBte();
+    break;
+  case RA8876_REG_SDRCR:
+    if (v & 0x01)
+      initSdram();
+    break;
+  default:
+    break;
+  }
+}
+
+uint8_t RA8876Emulator::readRegister(uint8_t reg)
+{
+  if ((reg >= RA8876_REG_PWDULX0) && (reg <= RA8876_REG_PWH1))
+    return m_pipRegs[(m_regs[RA8876_REG_MPWCTR] >> 4) & 1][reg - RA8876_REG_PWDULX0];
+
+  switch (reg)
+  {
+  case RA8876_REG_DCR0:
+  case RA8876_REG_DCR1:
+    return (m_regs[reg] & 0x7F) | (engineBusy() ? 0x80 : 0x00);
+  case RA8876_REG_BTE_CTRL0:
+    return (m_regs[reg] & 0xEF) | (engineBusy() ? 0x10 : 0x00);
+  case RA8876_REG_INTF:
+    return (busTime() / m_frameNs > m_vsyncCleared) ? 0x10 : 0x00;
+  default:
+    return m_regs[reg];
+  }
+}
+
+void RA8876Emulator::initSdram(void)
+{
+  uint8_t sdrar = m_regs[RA8876_REG_SDRAR];
+
+  uint32_t banks   = (sdrar & 0x20) ? 4 : 2;
+  uint32_t rowBits = 11 + ((sdrar >> 3) & 0x03);
+  uint32_t colBits = 8 + (sdrar & 0x07);
+
+  // 16-bit wide SDRAM
+  m_sdram.assign((banks << rowBits << colBits) * 2, 0);
+}
+
+//
+// Canvas access
+//
+
+int RA8876Emulator::canvasBpp(void) const
+{
+  switch (m_regs[RA8876_REG_AW_COLOR] & 0x03)
+  {
+  case 0:
+    return 1;
+  case 1:
+    return 2;
+  default:
+    return 3;
+  }
+}
+
+int RA8876Emulator::displayBpp(void) const
+{
+  switch ((m_regs[RA8876_REG_MPWCTR] >> 2) & 0x03)
+  {
+  case 0:
+    return 1;
+  case 1:
+    return 2;
+  default:
+    return 3;
+  }
+}
+
+bool RA8876Emulator::inActiveWindow(int x, int y) const
+{
+  int wx = reg16(RA8876_REG_AWUL_X0) & 0x1FFF;
+  int wy = reg16(RA8876_REG_AWUL_Y0) & 0x1FFF;
+  int ww = reg16(RA8876_REG_AW_WTH0) & 0x1FFF;
+  int wh = reg16(RA8876_REG_AW_HT0) & 0x1FFF;
+
+  return (x >= wx) && (x < wx + ww) && (y >= wy) && (y < wy + wh);
+}
+
+void RA8876Emulator::storePixel(uint32_t address, int bpp, uint32_t value)
+{
+  if (m_sdram.empty())
+    return;
+
+  for (int i = 0; i < bpp; i++)
+    m_sdram[(address + i) % m_sdram.size()] = (value >> (i * 8)) & 0xFF;
+}
+
+uint32_t RA8876Emulator::loadPixel(uint32_t address, int bpp) const
+{
+  if (m_sdram.empty())
+    return 0;
+
+  uint32_t value = 0;
+  for (int i = 0; i < bpp; i++)
+    value |= (uint32_t) m_sdram[(address + i) % m_sdram.size()] << (i * 8);
+
+  return value;
+}
+
+uint32_t RA8876Emulator::packColor(uint8_t r, uint8_t g, uint8_t b, int bpp) const
+{
+  switch (bpp)
+  {
+  case 1:
+    return RGB332(r, g, b);
+  case 2:
+    return RGB565(r, g, b);
+  default:
+    return ((uint32_t) r << 16) | (g << 8) | b;
+  }
+}
+
+uint32_t RA8876Emulator::foregroundColor(void) const
+{
+  return packColor(m_regs[RA8876_REG_FGCR], m_regs[RA8876_REG_FGCG], m_regs[RA8876_REG_FGCB], canvasBpp());
+}
+
+uint32_t RA8876Emulator::backgroundColor(void) const
+{
+  return packColor(m_regs[RA8876_REG_BGCR], m_regs[RA8876_REG_BGCG], m_regs[RA8876_REG_BGCB], canvasBpp());
+}
+
+// Draws one pixel in canvas coordinates, clipped to the active window.
+void RA8876Emulator::plot(int x, int y, uint32_t value)
+{
+  if (!inActiveWindow(x, y))
+    return;
+
+  int bpp = canvasBpp();
+  uint32_t base = reg32(RA8876_REG_CVSSA0);
+  uint32_t width = reg16(RA8876_REG_CVS_IMWTH0) & 0x1FFF;
+
+  storePixel(base + (((uint32_t) y * width) + x) * bpp, bpp, value);
+}
+
+uint32_t RA8876Emulator::memoryPixel(uint32_t address, int width, int x, int y, int bpp) const
+{
+  return loadPixel(address + (((uint32_t) y * width) + x) * bpp, bpp);
+}
+
+uint32_t RA8876Emulator::canvasPixel(int x, int y) const
+{
+  return memoryPixel(reg32(RA8876_REG_CVSSA0), reg16(RA8876_REG_CVS_IMWTH0) & 0x1FFF, x, y, canvasBpp());
+}
+
+// Returns the pixel scanned out at (x, y) and its bytes per pixel. PIP 1 lies above
+//  PIP 2, which lies above the main window.
+uint32_t RA8876Emulator::scanPixel(int x, int y, int *bpp) const
+{
+  for (int pip = 0; pip < 2; pip++)
+  {
+    if (!(m_regs[RA8876_REG_MPWCTR] & (0x80 >> pip)))
+      continue;
+
+    int px = x - (pipReg16(pip, RA8876_REG_PWDULX0) & 0x1FFC);
+    int py = y - (pipReg16(pip, RA8876_REG_PWDULY0) & 0x1FFF);
+    if ((px < 0) || (py < 0) || (px >= pipReg16(pip, RA8876_REG_PWW0)) || (py >= pipReg16(pip, RA8876_REG_PWH0)))
+      continue;
+
+    uint32_t base = pipReg16(pip, RA8876_REG_PISA0) | ((uint32_t) pipReg16(pip, RA8876_REG_PISA2) << 16);
+    int width = pipReg16(pip, RA8876_REG_PIW0) & 0x1FFF;
+
+    int depth = (m_regs[RA8876_REG_PIPCDEP] >> (pip ? 0 : 2)) & 0x03;
+    *bpp = (depth >= 2) ? 3 : depth + 1;
+
+    return memoryPixel(base, width, px + pipReg16(pip, RA8876_REG_PWIULX0), py + pipReg16(pip, RA8876_REG_PWIULY0), *bpp);
+  }
+
+  uint32_t base = reg32(RA8876_REG_MISA0);
+  int width = reg16(RA8876_REG_MIW0) & 0x1FFF;
+  int ox = reg16(RA8876_REG_MWULX0) & 0x1FFC;
+  int oy = reg16(RA8876_REG_MWULY0) & 0x1FFF;
+
+  *bpp = displayBpp();
+  return memoryPixel(base, width, x + ox, y + oy, *bpp);
+}
+
+uint32_t RA8876Emulator::displayPixel(int x, int y) const
+{
+  int bpp;
+  return scanPixel(x, y, &bpp);
+}
+
+bool RA8876Emulator::saveDisplay(const char *path) const
+{
+  int width  = ((m_regs[RA8876_REG_HDWR] + 1) * 8) + m_regs[RA8876_REG_HDWFTR];
+  int height = reg16(RA8876_REG_VDHR0) + 1;
+
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return false;
+
+  fprintf(f, "P6\n%d %d\n255\n", width, height);
+
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      int bpp;
+      uint32_t v = scanPixel(x, y, &bpp);
+      uint8_t rgb[3];
+
+      if (bpp == 1)
+      {
+        rgb[0] = v & 0xE0;
+        rgb[1] = (v << 3) & 0xE0;
+        rgb[2] = (v << 6) & 0xC0;
+      }
+      else if (bpp == 2)
+      {
+        rgb[0] = (v >> 8) & 0xF8;
+        rgb[1] = (v >> 3) & 0xFC;
+        rgb[2] = (v << 3) & 0xF8;
+      }
+      else
+      {
+        rgb[0] = v >> 16;
+        rgb[1] = v >> 8;
+        rgb[2] = v;
+      }
+
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+
+  fclose(f);
+
+  return true;
+}
+
+//
+// Host memory port
+//
+
+void RA8876Emulator::advanceGraphicCursor(void)
+{
+  int wx = reg16(RA8876_REG_AWUL_X0) & 0x1FFF;
+  int wy = reg16(RA8876_REG_AWUL_Y0) & 0x1FFF;
+  int ww = reg16(RA8876_REG_AW_WTH0) & 0x1FFF;
+  int wh = reg16(RA8876_REG_AW_HT0) & 0x1FFF;
+
+  int x = reg16(RA8876_REG_CURH0) + 1;
+  int y = reg16(RA8876_REG_CURV0);
+
+  if (x >= wx + ww)
+  {
+    x = wx;
+    if (++y >= wy + wh)
+      y = wy;
+  }
+
+  setReg16(RA8876_REG_CURH0, x);
+  setReg16(RA8876_REG_CURV0, y);
+}
+
+// Pixel bytes arrive low byte first. Once a whole pixel has been received it is
+//  stored at the graphic cursor, and the cursor moves on within the active window.
+void RA8876Emulator::memoryWrite(uint8_t x)
+{
+  fifoPush(m_writeNs);
+
+  m_pixel[m_pixelBytes++] = x;
+
+  int bpp = canvasBpp();
+  if (m_pixelBytes < bpp)
+    return;
+
+  m_pixelBytes = 0;
+
+  uint32_t value = 0;
+  for (int i = 0; i < bpp; i++)
+    value |= (uint32_t) m_pixel[i] << (i * 8);
+
+  if (m_regs[RA8876_REG_AW_COLOR] & 0x04)
+  {
+    // Linear addressing: the cursor registers hold a byte address
+    uint32_t address = reg32(RA8876_REG_CURH0);
+    storePixel(address, bpp, value);
+    setReg16(RA8876_REG_CURH0, (address + bpp) & 0xFFFF);
+    setReg16(RA8876_REG_CURV0, (address + bpp) >> 16);
+    return;
+  }
+
+  plot(reg16(RA8876_REG_CURH0), reg16(RA8876_REG_CURV0), value);
+  advanceGraphicCursor();
+}
+
+// The first read after the cursor moves is a dummy read, per data sheet section 11.
+uint8_t RA8876Emulator::memoryRead(void)
+{
+  if (m_readDummy)
+  {
+    m_readDummy = false;
+    m_pixelBytes = 0;
+    return 0;
+  }
+
+  int bpp = canvasBpp();
+  uint32_t value = canvasPixel(reg16(RA8876_REG_CURH0), reg16(RA8876_REG_CURV0));
+  uint8_t x = (value >> (m_pixelBytes * 8)) & 0xFF;
+
+  if (++m_pixelBytes >= bpp)
+  {
+    m_pixelBytes = 0;
+    advanceGraphicCursor();
+  }
+
+  return x;
+}
+
+//
+// Geometry engine
+//
+
+void RA8876Emulator::startTask(uint64_t cost)
+{
+  // The engine starts once any earlier work has drained
+  uint64_t start = busTime();
+  if (m_busyUntil > start)
+    start = m_busyUntil;
+  if (!m_fifo.empty() && (m_fifo.back() > start))
+    start = m_fifo.back();
+
+  m_busyUntil = start + cost;
+}
+
+uint64_t RA8876Emulator::drawLine(int x1, int y1, int x2, int y2, uint32_t color)
+{
+  int dx = abs(x2 - x1), sx = (x1 < x2) ? 1 : -1;
+  int dy = -abs(y2 - y1), sy = (y1 < y2) ? 1 : -1;
+  int err = dx + dy;
+  uint64_t pixels = 0;
+
+  for (;;)
+  {
+    plot(x1, y1, color);
+    pixels++;
+
+    if ((x1 == x2) && (y1 == y2))
+      break;
+
+    int e2 = 2 * err;
+    if (e2 >= dy)
+    {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx)
+    {
+      err += dx;
+      y1 += sy;
+    }
+  }
+
+  return pixels;
+}
+
+uint64_t RA8876Emulator::fillSpan(int x1, int x2, int y, uint32_t color)
+{
+  if (x1 > x2)
+  {
+    int t = x1;
+    x1 = x2;
+    x2 = t;
+  }
+
+  for (int x = x1; x <= x2; x++)
+    plot(x, y, color);
+
+  return x2 - x1 + 1;
+}
+
+uint64_t RA8876Emulator::drawTriangle(bool fill, uint32_t color)
+{
+  int x[3] = { reg16(RA8876_REG_DLHSR0), reg16(RA8876_REG_DLHER0), reg16(RA8876_REG_DTPH0) };
+  int y[3] = { reg16(RA8876_REG_DLVSR0), reg16(RA8876_REG_DLVER0), reg16(RA8876_REG_DTPV0) };
+  uint64_t pixels = 0;
+
+  if (fill)
+  {
+    int ymin = y[0], ymax = y[0];
+    for (int i = 1; i < 3; i++)
+    {
+      if (y[i] < ymin) ymin = y[i];
+      if (y[i] > ymax) ymax = y[i];
+    }
+
+    // Scanline fill: intersect each row with the three edges
+    for (int row = ymin; row <= ymax; row++)
+    {
+      int xmin = 0x7FFF, xmax = -0x7FFF;
+      for (int i = 0; i < 3; i++)
+      {
+        int j = (i + 1) % 3;
+        int ya = y[i], yb = y[j];
+        if ((row < ((ya < yb) ? ya : yb)) || (row > ((ya > yb) ? ya : yb)))
+          continue;
+
+        int xs;
+        if (ya == yb)
+        {
+          xs = x[i];
+          if (x[j] < xmin) xmin = x[j];
+          if (x[j] > xmax) xmax = x[j];
+        }
+        else
+        {
+          xs = x[i] + ((x[j] - x[i]) * (row - ya)) / (yb - ya);
+        }
+
+        if (xs < xmin) xmin = xs;
+        if (xs > xmax) xmax = xs;
+      }
+
+      if (xmin <= xmax)
+        pixels += fillSpan(xmin, xmax, row, color);
+    }
+  }
+  else
+  {
+    pixels += drawLine(x[0], y[0], x[1], y[1], color);
+    pixels += drawLine(x[1], y[1], x[2], y[2], color);
+    pixels += drawLine(x[2], y[2], x[0], y[0], color);
+  }
+
+  return pixels;
+}
+
+uint64_t RA8876Emulator::drawRect(bool fill, uint32_t color)
+{
+  int x1 = reg16(RA8876_REG_DLHSR0), y1 = reg16(RA8876_REG_DLVSR0);
+  int x2 = reg16(RA8876_REG_DLHER0), y2 = reg16(RA8876_REG_DLVER0);
+  uint64_t pixels = 0;
+
+  if (y1 > y2)
+  {
+    int t = y1;
+    y1 = y2;
+    y2 = t;
+  }
+
+  if (fill)
+  {
+    for (int y = y1; y <= y2; y++)
+      pixels += fillSpan(x1, x2, y, color);
+  }
+  else
+  {
+    pixels += fillSpan(x1, x2, y1, color);
+    pixels += fillSpan(x1, x2, y2, color);
+    pixels += drawLine(x1, y1, x1, y2, color);
+    pixels += drawLine(x2, y1, x2, y2, color);
+  }
+
+  return pixels;
+}
+
+uint64_t RA8876Emulator::drawEllipse(bool fill, uint32_t color)
+{
+  int cx = reg16(RA8876_REG_DEHR0), cy = reg16(RA8876_REG_DEVR0);
+  int a = reg16(RA8876_REG_ELL_A0), b = reg16(RA8876_REG_ELL_B0);
+  uint64_t pixels = 0;
+
+  // Outer boundary at radius + 0.5; outlines are the ring between that and radius - 0.5
+  double ao = a + 0.5, bo = b + 0.5;
+  double ai = a - 0.5, bi = b - 0.5;
+
+  for (int dy = -b; dy <= b; dy++)
+  {
+    for (int dx = -a; dx <= a; dx++)
+    {
+      double outer = (dx * dx) / (ao * ao) + (dy * dy) / (bo * bo);
+      if (outer > 1.0)
+        continue;
+
+      if (!fill && (ai > 0) && (bi > 0))
+      {
+        double inner = (dx * dx) / (ai * ai) + (dy * dy) / (bi * bi);
+        if (inner < 1.0)
+          continue;
+      }
+
+      plot(cx + dx, cy + dy, color);
+      pixels++;
+    }
+  }
+
+  return pixels;
+}
+
+void RA8876Emulator::startDcr0(uint8_t v)
+{
+  uint32_t color = foregroundColor();
+  uint64_t pixels;
+
+  if (v & 0x02)
+    pixels = drawTriangle(v & 0x20, color);
+  else
+    pixels = drawLine(reg16(RA8876_REG_DLHSR0), reg16(RA8876_REG_DLVSR0), reg16(RA8876_REG_DLHER0), reg16(RA8876_REG_DLVER0), color);
+
+  startTask(pixels * m_pixelNs);
+  m_stats.shapes++;
+}
+
+void RA8876Emulator::startDcr1(uint8_t v)
+{
+  uint32_t color = foregroundColor();
+  uint64_t pixels;
+
+  // Bits 5..4 select the shape: 00 ellipse, 01 curve, 10 rectangle, 11 rounded rectangle.
+  //  Curves and rounded corners are not modelled; they draw as their bounding shapes.
+  switch ((v >> 4) & 0x03)
+  {
+  case 0:
+  case 1:
+    pixels = drawEllipse(v & 0x40, color);
+    break;
+  default:
+    pixels = drawRect(v & 0x40, color);
+    break;
+  }
+
+  startTask(pixels * m_pixelNs);
+  m_stats.shapes++;
+}
+
+//
+// Block transfer engine
+//
+
+// Bytes per pixel for a BTE colour depth field (00 8bpp, 01 16bpp, 1x 24bpp).
+static int bteBpp(uint8_t depth)
+{
+  return (depth >= 2) ? 3 : depth + 1;
+}
+
+static uint32_t applyRop(uint8_t rop, uint32_t s0, uint32_t s1)
+{
+  uint32_t d = 0;
+
+  // Each bit of the ROP code is the result for one combination of source bits
+  if (rop & 0x8) d |=  s0 &  s1;
+  if (rop & 0x4) d |=  s0 & ~s1;
+  if (rop & 0x2) d |= ~s0 &  s1;
+  if (rop & 0x1) d |= ~s0 & ~s1;
+
+  return d;
+}
+
+uint32_t RA8876Emulator::btePixel(uint8_t base, int bpp, int x, int y) const
+{
+  uint32_t width = reg16(base + 4) & 0x1FFF;
+  uint32_t start = reg32(base);
+  int px = reg16(base + 6) + x;
+  int py = reg16(base + 8) + y;
+
+  return start + (((uint32_t) py * width) + px) * bpp;
+}
+
+void RA8876Emulator::startBte(void)
+{
+  uint8_t ctrl1 = m_regs[RA8876_REG_BTE_CTRL1];
+  uint8_t colr  = m_regs[RA8876_REG_BTE_COLR];
+  int s0Bpp = bteBpp((colr >> 5) & 0x03);
+  int s1Bpp = bteBpp((colr >> 2) & 0x07);
+  int dtBpp = bteBpp(colr & 0x03);
+  int width  = reg16(RA8876_REG_BTE_WTH0) & 0x1FFF;
+  int height = reg16(RA8876_REG_BTE_HIG0) & 0x1FFF;
+  uint32_t mask = (dtBpp == 3) ? 0xFFFFFF : ((1UL << (dtBpp * 8)) - 1);
+
+  switch (ctrl1 & 0x0F)
+  {
+  case RA8876_BTE_MEMORY_COPY_ROP:
+    for (int y = 0; y < height; y++)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        uint32_t s0 = loadPixel(btePixel(RA8876_REG_S0_STR0, s0Bpp, x, y), s0Bpp);
+        uint32_t s1 = loadPixel(btePixel(RA8876_REG_S1_STR0, s1Bpp, x, y), s1Bpp);
+        storePixel(btePixel(RA8876_REG_DT_STR0, dtBpp, x, y), dtBpp, applyRop(ctrl1 >> 4, s0, s1) & mask);
+      }
+    }
+    break;
+  case RA8876_BTE_MEMORY_COPY_CHROMA:
+    {
+      uint32_t key = packColor(m_regs[RA8876_REG_BGCR], m_regs[RA8876_REG_BGCG], m_regs[RA8876_REG_BGCB], s0Bpp);
+
+      for (int y = 0; y < height; y++)
+      {
+        for (int x = 0; x < width; x++)
+        {
+          uint32_t s0 = loadPixel(btePixel(RA8876_REG_S0_STR0, s0Bpp, x, y), s0Bpp);
+          if (s0 != key)
+            storePixel(btePixel(RA8876_REG_DT_STR0, dtBpp, x, y), dtBpp, s0);
+        }
+      }
+    }
+    break;
+  case RA8876_BTE_MEMORY_COPY_EXPAND:
+  case RA8876_BTE_MEMORY_COPY_EXPAND_CHROMA:
+    {
+      // Source 0 is a bitmap packed into pixels of its colour depth, most significant
+      //  bit first; each row starts at the bit given in BTE_CTRL1
+      int bits = s0Bpp * 8;
+      int skip = bits - 1 - ((ctrl1 >> 4) % bits);
+      bool transparent = (ctrl1 & 0x0F) == RA8876_BTE_MEMORY_COPY_EXPAND_CHROMA;
+      uint32_t fg = packColor(m_regs[RA8876_REG_FGCR], m_regs[RA8876_REG_FGCG], m_regs[RA8876_REG_FGCB], dtBpp);
+      uint32_t bg = packColor(m_regs[RA8876_REG_BGCR], m_regs[RA8876_REG_BGCG], m_regs[RA8876_REG_BGCB], dtBpp);
+
+      for (int y = 0; y < height; y++)
+      {
+        for (int x = 0; x < width; x++)
+        {
+          int bit = skip + x;
+          uint32_t unit = loadPixel(btePixel(RA8876_REG_S0_STR0, s0Bpp, bit / bits, y), s0Bpp);
+          bool on = (unit >> (bits - 1 - (bit % bits))) & 1;
+
+          if (on || !transparent)
+            storePixel(btePixel(RA8876_REG_DT_STR0, dtBpp, x, y), dtBpp, on ? fg : bg);
+        }
+      }
+    }
+    break;
+  default:
+    break;  // Not modelled
+  }
+
+  startTask((uint64_t) width * height * m_pixelNs);
+  m_stats.blits++;
+}
+
+//
+// Text engine
+//
+
+bool RA8876Emulator::textIsMultiByte(uint8_t lead) const
+{
+  uint8_t source = m_regs[RA8876_REG_CCR0] >> 6;
+  if (source == 0)
+    return false;  // Internal CGROM is always 8-bit
+
+  if (source == 2)
+    return lead >= 0x80;  // User-defined: full-width codes are 0x8000 and above
+
+  switch (m_regs[RA8876_REG_GTFNT_CR] >> 3)
+  {
+  case RA8876_FONT_ENCODING_UNICODE:
+    return true;
+  case RA8876_FONT_ENCODING_GB2312:
+  case RA8876_FONT_ENCODING_GB18030:
+  case RA8876_FONT_ENCODING_BIG5:
+  case RA8876_FONT_ENCODING_UNIJAPAN:
+  case RA8876_FONT_ENCODING_JIS0208:
+    return lead >= 0x80;
+  default:
+    return false;
+  }
+}
+
+void RA8876Emulator::textWrite(uint8_t x)
+{
+  if (m_haveTextLead)
+  {
+    m_haveTextLead = false;
+    uint16_t code = (m_textLead << 8) | x;
+    renderChar(code, code >= 0x80);
+  }
+  else if (textIsMultiByte(x))
+  {
+    m_textLead = x;
+    m_haveTextLead = true;
+    fifoPush(m_writeNs);
+  }
+  else
+  {
+    renderChar(x, false);
+  }
+}
+
+// User-defined glyphs come from CGRAM in SDRAM: one bit per pixel, rows padded to
+//  whole bytes, half-width codes 0x00 up and full-width codes 0x8000 up each counting
+//  from the CGRAM start address.
+// The font ROMs are not available to the emulator, so their glyphs are a placeholder:
+//  a pattern derived from the character code, inset by one pixel, blank for spaces.
+bool RA8876Emulator::glyphBit(uint16_t code, bool fullWidth, int gx, int gy, int w, int h) const
+{
+  if ((m_regs[RA8876_REG_CCR0] >> 6) == 2)
+  {
+    int rowBytes = (w + 7) / 8;
+    uint32_t index = fullWidth ? (code & 0x7FFF) : (code & 0xFF);
+    uint32_t address = reg32(RA8876_REG_CGRAM_STR0) + (index * rowBytes * h) + (gy * rowBytes) + (gx / 8);
+
+    return (loadPixel(address, 1) >> (7 - (gx & 7))) & 1;
+  }
+
+  if ((code == 0x20) || (code == 0x3000))
+    return false;
+
+  if ((gx == 0) || (gy == 0) || (gx == w - 1) || (gy == h - 1))
+    return false;
+
+  return ((code * 7 + gx * 3 + gy * 5) % 4) == 0;
+}
+
+void RA8876Emulator::renderChar(uint16_t code, bool fullWidth)
+{
+  int size = (m_regs[RA8876_REG_CCR0] >> 4) & 0x03;
+  if (size > 2)
+    size = 2;
+
+  int h = (size + 2) * 8;
+  int w = fullWidth ? h : h / 2;
+
+  int sx = ((m_regs[RA8876_REG_CCR1] >> 2) & 0x03) + 1;
+  int sy = (m_regs[RA8876_REG_CCR1] & 0x03) + 1;
+  bool transparent = m_regs[RA8876_REG_CCR1] & 0x40;
+
+  int spacing = m_regs[RA8876_REG_F2FSSR] & 0x3F;
+  int lineGap = m_regs[RA8876_REG_FLDR] & 0x1F;
+
+  int wx = reg16(RA8876_REG_AWUL_X0) & 0x1FFF;
+  int ww = reg16(RA8876_REG_AW_WTH0) & 0x1FFF;
+
+  int x = reg16(RA8876_REG_F_CURX0);
+  int y = reg16(RA8876_REG_F_CURY0);
+
+  // Wrap to the next line when the character would cross the active window edge
+  if (x + (w * sx) > wx + ww)
+  {
+    x = wx;
+    y += (h * sy) + lineGap;
+  }
+
+  uint32_t fg = foregroundColor();
+  uint32_t bg = backgroundColor();
+
+  for (int gy = 0; gy < h; gy++)
+  {
+    for (int gx = 0; gx < w; gx++)
+    {
+      bool on = glyphBit(code, fullWidth, gx, gy, w, h);
+      if (!on && transparent)
+        continue;
+
+      for (int py = 0; py < sy; py++)
+        for (int px = 0; px < sx; px++)
+          plot(x + (gx * sx) + px, y + (gy * sy) + py, on ? fg : bg);
+    }
+  }
+
+  setReg16(RA8876_REG_F_CURX0, x + (w * sx) + spacing);
+  setReg16(RA8876_REG_F_CURY0, y);
+
+  m_stats.chars++;
+  m_textLog.push_back(code);
+
+  uint64_t cost = (uint64_t) w * h * sx * sy * m_pixelNs;
+  fifoPush(cost);
+
+  uint64_t done = m_fifo.back();
+  if (done > m_busyUntil)
+    m_busyUntil = done;
+}
@@ -0,0 +1,234 @@
+// Host-side emulator of the RA8876, for exercising the library without a panel.
+//
+// The emulator sits underneath the unmodified RA8876 class: the Arduino.h and SPI.h
+//  shims in this directory forward chip select edges and SPI bytes to it, and it
+//  decodes them the way the chip does (data sheet section 7.3.2). It can instead
+//  decode an 8080 or 6800 parallel bus from the GPIO edges made by
+//  RA8876ParallelTransport (section 7.1 and 7.2). It models:
+//
+//  - The register file, including the status register bits polled by the driver
+//    (write FIFO full/empty, core task busy, SDRAM ready).
+//  - SDRAM sized from SDRAR once SDRCR is triggered, used as the backing store for
+//    the canvas and the main display window.
+//  - A 16-bit host data bus, when driven through RA8876EmulatorTransport.
+//  - Host memory writes through MRWDP in graphics mode (block addressing within
+//    the active window, or linear addressing from the cursor address), queued in a
+//    write FIFO that drains at the SDRAM write rate. Writes made while it is full
+//    are dropped, as on the chip.
+//  - The geometry engine commands in DCR0/DCR1 (lines, triangles, rectangles,
+//    ellipses), clipped to the active window.
+//  - Block transfer engine memory copies with raster operations, a chroma key or
+//    colour expansion.
+//  - PIP windows 1 and 2 composited over the main window on scan-out.
+//  - Frame timing: the VSYNC event flag in INTF, and whether main image address
+//    changes land in vertical blanking.
+//  - The text engine, with cursor advance and wrapping. User-defined glyphs are
+//    read from CGRAM. The font ROMs are not available, so their glyphs are drawn
+//    as a deterministic placeholder pattern.
+//
+// Timing is virtual (see Arduino.h): bus traffic advances the clock, and engine
+//  operations keep the busy bit set for a duration proportional to the number of
+//  pixels they touch. This makes throughput measurements repeatable.
+
+#ifndef RA8876_EMULATOR_H
+#define RA8876_EMULATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include <RA8876.h>
+
+struct RA8876EmulatorStats
+{
+  uint64_t busCycles;       // Transfers on the host bus (SPI bytes or parallel cycles)
+  uint64_t busBytes;        // Bytes moved over the host bus
+  uint64_t csAssertions;    // Number of times chip select was asserted
+  uint64_t cmdWrites;       // Command (register address) writes
+  uint64_t dataWrites;      // Data writes, including memory writes
+  uint64_t dataReads;       // Data reads, including memory reads
+  uint64_t statusReads;     // Status register reads
+  uint64_t memoryWrites;    // Data writes to MRWDP
+  uint64_t shapes;          // Geometry engine operations started
+  uint64_t blits;           // Block transfer engine operations started
+  uint64_t chars;           // Characters rendered by the text engine
+  uint64_t fifoOverflows;   // Memory writes lost because the write FIFO was full
+  uint64_t busyViolations;  // Engine register writes made while a task was running
+  uint64_t tearingWrites;   // Main image address writes made outside vertical blanking
+  uint64_t deselectedCycles;  // Bus cycles made while chip select was high, which the chip ignores
+};
+
+// Difference between two snapshots, e.g. the traffic caused by one primitive.
+RA8876EmulatorStats operator-(const RA8876EmulatorStats &a, const RA8876EmulatorStats &b);
+
+class RA8876Emulator
+{
+private:
+  int m_csPin;
+  int m_resetPin;
+
+  uint8_t m_regs[256];
+  uint8_t m_addr;          // Currently selected register
+
+  // PIP window registers (PWDULX0..PWH1), one set per window, banked by MPWCTR bit 4
+  uint8_t m_pipRegs[2][RA8876_REG_PWH1 - RA8876_REG_PWDULX0 + 1];
+
+  std::vector<uint8_t> m_sdram;
+
+  // SPI framing state
+  bool    m_csActive;
+  bool    m_haveCycleType;
+  uint8_t m_cycleType;
+
+  // GPIO parallel bus, if attached with attachParallel()
+  bool    m_parallel;
+  enum ParallelBusMode m_busMode;
+  int     m_busWidth;
+  int     m_dataPins[16];
+  int     m_a0Pin;
+  int     m_strobePin;       // WR# or E
+  int     m_readPin;         // RD# or R/W#
+  int     m_strobeLevel;
+  int     m_readLevel;
+
+  // Memory write/read assembly
+  uint8_t m_pixel[3];
+  int     m_pixelBytes;
+  bool    m_readDummy;
+
+  // Text engine state
+  uint8_t m_textLead;
+  bool    m_haveTextLead;
+
+  // Timing
+  uint64_t m_busyUntil;
+  std::vector<uint64_t> m_fifo;  // Completion times of queued memory writes
+  int      m_fifoDepth;
+  uint32_t m_pixelNs;            // Geometry/text engine time per pixel
+  uint32_t m_writeNs;            // Time to retire one memory write from the FIFO
+  uint64_t m_busTime;            // Time of the bus cycles being replayed, or 0 for now
+
+  // Display timing
+  uint64_t m_frameNs;            // Frame period; VSYNC starts each frame
+  uint64_t m_blankNs;            // Vertical blanking time following VSYNC
+  uint64_t m_vsyncCleared;       // Frame number in which the VSYNC flag was last cleared
+
+  RA8876EmulatorStats m_stats;
+
+  std::vector<uint16_t> m_textLog;
+
+  uint16_t reg16(uint8_t r) const { return m_regs[r] | (m_regs[r + 1] << 8); };
+  uint32_t reg32(uint8_t r) const { return reg16(r) | ((uint32_t) reg16(r + 2) << 16); };
+  void setReg16(uint8_t r, uint16_t v) { m_regs[r] = v & 0xFF; m_regs[r + 1] = v >> 8; };
+
+  uint64_t busTime(void) const;
+  bool engineBusy(void) const;
+  int  fifoLevel(void);
+  void fifoPush(uint64_t cost);
+
+  void writeRegister(uint8_t reg, uint8_t v);
+  uint8_t readRegister(uint8_t reg);
+
+  // Canvas access
+  int  canvasBpp(void) const;
+  uint16_t pipReg16(int pip, uint8_t r) const { return m_pipRegs[pip][r - RA8876_REG_PWDULX0] | (m_pipRegs[pip][r - RA8876_REG_PWDULX0 + 1] << 8); };
+  uint32_t scanPixel(int x, int y, int *bpp) const;
+  bool inActiveWindow(int x, int y) const;
+  void storePixel(uint32_t address, int bpp, uint32_t value);
+  uint32_t loadPixel(uint32_t address, int bpp) const;
+  uint32_t packColor(uint8_t r, uint8_t g, uint8_t b, int bpp) const;
+  uint32_t foregroundColor(void) const;
+  uint32_t backgroundColor(void) const;
+  void plot(int x, int y, uint32_t value);
+
+  // Host memory port
+  void memoryWrite(uint8_t x);
+  uint8_t memoryRead(void);
+  void advanceGraphicCursor(void);
+
+  // Geometry engine
+  uint64_t drawLine(int x1, int y1, int x2, int y2, uint32_t color);
+  uint64_t fillSpan(int x1, int x2, int y, uint32_t color);
+  uint64_t drawTriangle(bool fill, uint32_t color);
+  uint64_t drawRect(bool fill, uint32_t color);
+  uint64_t drawEllipse(bool fill, uint32_t color);
+  void startDcr0(uint8_t v);
+  void startDcr1(uint8_t v);
+  void startTask(uint64_t cost);
+
+  // Block transfer engine
+  uint32_t btePixel(uint8_t base, int bpp, int x, int y) const;
+  void startBte(void);
+
+  // Text engine
+  void textWrite(uint8_t x);
+  bool textIsMultiByte(uint8_t lead) const;
+  void renderChar(uint16_t code, bool fullWidth);
+  bool glyphBit(uint16_t code, bool fullWidth, int gx, int gy, int w, int h) const;
+
+  void initSdram(void);
+
+  void parallelPinChanged(int pin, int value);
+  void parallelWrite(void);
+  void parallelRead(void);
+
+public:
+  RA8876Emulator();
+  ~RA8876Emulator();
+
+  // Connects this emulator to the SPI and GPIO shims, using the given pins.
+  void attachSpi(int csPin, int resetPin = -1);
+
+  // Connects this emulator to the GPIO shim as a parallel bus, with the same pins as
+  //  given to RA8876ParallelTransport. Cycles are taken from the strobe edges, each
+  //  costing GPIO-speed time.
+  void attachParallel(enum ParallelBusMode mode, int width, const int *dataPins, int csPin, int a0Pin, int strobePin, int readPin, int resetPin = -1);
+
+  // Called by the shims.
+  static RA8876Emulator *attached(void);
+  void pinChanged(int pin, int value);
+  uint8_t spiTransfer(uint8_t x);
+
+  // Bus cycles, independent of the physical interface. Transports other than the SPI
+  //  shim report each cycle with countBusCycle().
+  void countBusCycle(int bytes) { m_stats.busCycles++; m_stats.busBytes += bytes; };
+  void csAssert(void);
+  void csRelease(void);
+  bool selected(void);  // False, counting a lost cycle, if chip select is high
+  void busCmdWrite(uint8_t x);
+  void busDataWrite(uint8_t x);
+  void busDataWrite16(uint16_t x);
+  uint8_t busDataRead(void);
+  uint16_t busDataRead16(void);
+  uint8_t busStatusRead(void);
+
+  // Transports that model a background transfer (e.g. DMA) deliver its cycles after the
+  //  fact. This sets the time at which the following cycles took place; 0 goes back to
+  //  the current time.
+  void setBusTime(uint64_t ns) { m_busTime = ns; };
+
+  void hardReset(void);
+
+  // Tuning
+  void setFifoDepth(int depth) { m_fifoDepth = depth; };
+  void setEngineSpeed(uint32_t pixelNs, uint32_t writeNs) { m_pixelNs = pixelNs; m_writeNs = writeNs; };
+  uint32_t writeNs(void) const { return m_writeNs; };
+  void setFrameTiming(uint64_t frameNs, uint64_t blankNs) { m_frameNs = frameNs; m_blankNs = blankNs; };
+
+  // Inspection
+  uint8_t reg(uint8_t r) const { return m_regs[r]; };
+  uint32_t sdramSize(void) const { return m_sdram.size(); };
+  const uint8_t *sdram(void) const { return m_sdram.empty() ? 0 : &m_sdram[0]; };
+  uint32_t memoryPixel(uint32_t address, int width, int x, int y, int bpp) const;
+  uint32_t canvasPixel(int x, int y) const;
+  uint32_t displayPixel(int x, int y) const;  // Raw value, at the depth of the window it comes from
+  int displayBpp(void) const;
+  bool saveDisplay(const char *path) const;  // Binary PPM of the visible display
+
+  const std::vector<uint16_t> &textLog(void) const { return m_textLog; };
+  void clearTextLog(void) { m_textLog.clear(); };
+
+  const RA8876EmulatorStats &stats(void) const { return m_stats; };
+  void resetStats(void);
+};
+
+#endif
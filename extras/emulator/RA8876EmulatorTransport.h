@@ -0,0 +1,180 @@
+// Parallel host bus transport wired straight to an RA8876Emulator, for measuring the
+//  8- and 16-bit parallel modes without modelling individual GPIO edges.
+//
+// writeData16Async() is modelled as a DMA transfer: it returns at once, and the data
+//  reaches the emulator, timed as if sent at the bus rate from the moment the transfer
+//  started, once the virtual clock has passed its end. Polling transferBusy() costs
+//  one bus cycle of time, like a spinning CPU would. Like a real DMA controller it
+//  takes no notice of the write FIFO: each write checks for a full FIFO only in the
+//  emulator, which counts and drops it. If a bus cycle is shorter than the emulator's
+//  FIFO write time, outrunsFifo() reports it, and the driver sends FIFO-sized pieces.
+// Chip select follows the outermost transaction, as with RA8876ParallelTransport, and
+//  cycles made outside one are lost and counted in stats().deselectedCycles.
+
+#ifndef RA8876_EMULATOR_TRANSPORT_H
+#define RA8876_EMULATOR_TRANSPORT_H
+
+#include <RA8876Transport.h>
+
+#include "RA8876Emulator.h"
+
+class RA8876EmulatorTransport : public RA8876Transport
+{
+private:
+  RA8876Emulator *m_emu;
+  int      m_width;
+  uint32_t m_cycleNs;
+  int      m_transactions;
+
+  // Transfer in flight
+  const uint16_t        *m_asyncData;
+  size_t                 m_asyncCount;
+  RA8876TransferCallback m_asyncCallback;
+  void                  *m_asyncContext;
+  uint64_t               m_asyncStart;
+  uint64_t               m_asyncEnd;
+
+  // Returns false if the chip is not selected.
+  bool cycle(int bytes)
+  {
+    finishAsync();
+    hostAdvance(m_cycleNs);
+    m_emu->countBusCycle(bytes);
+    return m_emu->selected();
+  };
+
+  void deliverAsync(void)
+  {
+    int cycles = (m_width == 16) ? 1 : 2;
+
+    for (size_t i = 0; i < m_asyncCount; i++)
+    {
+      m_emu->setBusTime(m_asyncStart + (i + 1) * cycles * m_cycleNs);
+
+      if (m_width == 16)
+      {
+        m_emu->countBusCycle(2);
+        if (m_emu->selected())
+          m_emu->busDataWrite16(m_asyncData[i]);
+      }
+      else
+      {
+        m_emu->countBusCycle(1);
+        if (m_emu->selected())
+          m_emu->busDataWrite(m_asyncData[i] & 0xFF);
+        m_emu->countBusCycle(1);
+        if (m_emu->selected())
+          m_emu->busDataWrite(m_asyncData[i] >> 8);
+      }
+    }
+
+    m_emu->setBusTime(0);
+    m_asyncData = 0;
+
+    if (m_asyncCallback)
+      m_asyncCallback(m_asyncContext);
+  };
+
+  // Waits out any transfer in flight.
+  void finishAsync(void)
+  {
+    if (!m_asyncData)
+      return;
+
+    if (hostNanos() < m_asyncEnd)
+      hostAdvance(m_asyncEnd - hostNanos());
+
+    deliverAsync();
+  };
+
+public:
+  // cycleNs is the duration of one bus cycle; the data sheet minimum is around 50ns.
+  RA8876EmulatorTransport(RA8876Emulator *emu, int width = 8, uint32_t cycleNs = 50)
+  {
+    m_emu     = emu;
+    m_width   = (width == 16) ? 16 : 8;
+    m_cycleNs = cycleNs;
+
+    m_transactions = 0;
+    m_asyncData    = 0;
+  };
+
+  virtual void begin(void) {};
+  virtual void beginTransaction(void)
+  {
+    if (m_transactions++ == 0)
+      m_emu->csAssert();
+  };
+
+  virtual void endTransaction(void)
+  {
+    finishAsync();
+    if ((m_transactions > 0) && (--m_transactions == 0))
+      m_emu->csRelease();
+  };
+
+  virtual void writeCmd(uint8_t x) { if (cycle(1)) m_emu->busCmdWrite(x); };
+  virtual void writeData(uint8_t x) { if (cycle(1)) m_emu->busDataWrite(x); };
+  virtual uint8_t readData(void)
+  {
+    if (!cycle(1))
+      return 0xFF;
+
+    // A read cycle on a 16-bit bus takes a whole 16-bit memory value, even when only
+    //  the low byte is wanted
+    return (m_width == 16) ? (m_emu->busDataRead16() & 0xFF) : m_emu->busDataRead();
+  };
+  virtual uint8_t readStatus(void) { return cycle(1) ? m_emu->busStatusRead() : 0xFF; };
+
+  virtual bool is16Bit(void) { return m_width == 16; };
+
+  virtual void writeData16(uint16_t x)
+  {
+    if (m_width == 16)
+    {
+      if (cycle(2))
+        m_emu->busDataWrite16(x);
+    }
+    else
+    {
+      RA8876Transport::writeData16(x);
+    }
+  };
+
+  virtual uint16_t readData16(void)
+  {
+    if (m_width == 16)
+      return cycle(2) ? m_emu->busDataRead16() : 0xFFFF;
+    else
+      return cycle(1) ? m_emu->busDataRead() : 0xFF;
+  };
+
+  virtual void writeData16Async(const uint16_t *data, size_t count, RA8876TransferCallback callback, void *context)
+  {
+    finishAsync();
+
+    m_asyncData     = data;
+    m_asyncCount    = count;
+    m_asyncCallback = callback;
+    m_asyncContext  = context;
+    m_asyncStart    = hostNanos();
+    m_asyncEnd      = m_asyncStart + count * ((m_width == 16) ? 1 : 2) * m_cycleNs;
+  };
+
+  virtual bool outrunsFifo(void) { return m_cycleNs < m_emu->writeNs(); };
+
+  virtual bool transferBusy(void)
+  {
+    if (!m_asyncData)
+      return false;
+
+    hostAdvance(m_cycleNs);
+    if (hostNanos() < m_asyncEnd)
+      return true;
+
+    deliverAsync();
+    return false;
+  };
+};
+
+#endif
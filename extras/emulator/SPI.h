@@ -0,0 +1,52 @@
+// Minimal host-side stand-in for the Arduino SPI library. Every byte clocked out is
+//  handed to the attached RA8876Emulator, and advances the virtual clock by the time
+//  it would take at the clock rate of the current transaction.
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <Arduino.h>
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+public:
+  uint32_t m_clock;
+
+  SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+  {
+    (void) bitOrder;
+    (void) dataMode;
+    m_clock = clock;
+  };
+};
+
+class SPIClass
+{
+private:
+  uint32_t m_clock;
+
+public:
+  SPIClass() : m_clock(4000000) {};
+
+  void begin(void) {};
+  void end(void) {};
+
+  void beginTransaction(SPISettings settings) { m_clock = settings.m_clock; };
+  void endTransaction(void) {};
+
+  uint8_t transfer(uint8_t x);
+  uint16_t transfer16(uint16_t x);
+  void transfer(void *buf, size_t count);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,63 @@
+// Shared by the emulator test programs: a checking macro that reports each failure
+//  with its location and carries on, and a driver wired to a fresh emulator.
+// Each test program is a single source file whose main() returns testExit().
+
+#ifndef RA8876_TEST_H
+#define RA8876_TEST_H
+
+#include <stdio.h>
+
+#include <RA8876.h>
+
+#include "RA8876Emulator.h"
+#include "RA8876EmulatorTransport.h"
+
+static int testFailures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); testFailures++; } } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { long long va = (long long) (a), vb = (long long) (b); \
+       if (va != vb) { printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va, vb); testFailures++; } } while (0)
+
+// Prints the outcome and gives the exit status for main().
+static inline int testExit(const char *name)
+{
+  printf("%s: %s\n", name, testFailures ? "FAILED" : "ok");
+  return testFailures ? 1 : 0;
+}
+
+// An emulator with a driver on a parallel bus of the given width, initialised at the
+//  given display depth.
+struct TestRig
+{
+  RA8876Emulator          emu;
+  RA8876EmulatorTransport bus;
+  RA8876                  tft;
+  bool                    ready;
+
+  TestRig(int busWidth = 16, int depth = 16, uint32_t cycleNs = 50) : bus(&emu, busWidth, cycleNs), tft(&bus)
+  {
+    ready = tft.init(depth);
+  };
+
+  // Pixels of the visible display that differ from another rig's, over a rectangle.
+  int diffDisplay(TestRig &other, int x, int y, int width, int height)
+  {
+    int diff = 0;
+    for (int j = y; j < y + height; j++)
+      for (int i = x; i < x + width; i++)
+        if (emu.displayPixel(i, j) != other.emu.displayPixel(i, j))
+          diff++;
+
+    return diff;
+  };
+
+  bool clean(void)
+  {
+    return (emu.stats().busyViolations == 0) && (emu.stats().fifoOverflows == 0) && (emu.stats().deselectedCycles == 0);
+  };
+};
+
+#endif
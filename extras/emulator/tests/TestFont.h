@@ -0,0 +1,66 @@
+// A bitmap font built at run time for the tests: glyphs 'A' to 'D' of growing size,
+//  with pseudo-random coverage at the given bits per pixel, and two kerning pairs.
+
+#ifndef TEST_FONT_H
+#define TEST_FONT_H
+
+#include <vector>
+
+#include <RA8876Font.h>
+
+struct TestFont
+{
+  std::vector<uint8_t> bits;
+  RA8876Glyph          glyphs[4];
+  RA8876KernPair       kern[2];
+  RA8876Font           font;
+  std::vector<int>     coverage[4];  // Level of each pixel, row by row
+
+  TestFont(int bpp, unsigned seed)
+  {
+    uint32_t bit = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      int width = 5 + i * 7, height = 9 + i * 3;
+
+      glyphs[i].bitmapOffset = bit / 8;
+      glyphs[i].width        = width;
+      glyphs[i].height       = height;
+      glyphs[i].xAdvance     = width + 2;
+      glyphs[i].xOffset      = i - 1;
+      glyphs[i].yOffset      = -height + 2;
+
+      for (int p = 0; p < width * height; p++)
+      {
+        seed = seed * 1103515245 + 12345;
+        int level = (seed >> 16) & ((1 << bpp) - 1);
+        coverage[i].push_back(level);
+
+        for (int b = bpp - 1; b >= 0; b--, bit++)
+        {
+          if (bit / 8 >= bits.size())
+            bits.push_back(0);
+          if ((level >> b) & 1)
+            bits[bit / 8] |= 0x80 >> (bit % 8);
+        }
+      }
+
+      bit = (bit + 7) & ~7;  // Each glyph starts on a byte
+    }
+
+    kern[0].left = 'A';  kern[0].right = 'B';  kern[0].adjust = -3;
+    kern[1].left = 'B';  kern[1].right = 'A';  kern[1].adjust = 2;
+
+    font.bitmap    = &bits[0];
+    font.glyph     = glyphs;
+    font.first     = 'A';
+    font.last      = 'D';
+    font.yAdvance  = 40;
+    font.baseline  = 32;
+    font.bpp       = bpp;
+    font.kerning   = kern;
+    font.kernCount = 2;
+  };
+};
+
+#endif
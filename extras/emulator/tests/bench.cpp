@@ -0,0 +1,349 @@
+// Bus traffic and emulated time for the things the library does to save them. Times
+//  are on the emulator's virtual clock, so they count bus transfers and waits for the
+//  controller, not host CPU time. Run with "make bench".
+
+#include <RA8876TextBox.h>
+#include <RA8876Terminal.h>
+
+#include "RA8876Test.h"
+#include "TestFont.h"
+
+static void report(const char *label, const RA8876EmulatorStats &d, uint64_t ns)
+{
+  printf("  %-28s %8llu bytes %6llu cmds %5llu CS %5llu status %8.2f ms\n", label,
+         (unsigned long long) d.busBytes, (unsigned long long) d.cmdWrites, (unsigned long long) d.csAssertions,
+         (unsigned long long) d.statusReads, ns / 1e6);
+}
+
+// Runs a piece of drawing and reports what it cost.
+#define MEASURE(emu, label, code) \
+  do { RA8876EmulatorStats before_ = (emu).stats(); uint64_t t0_ = hostNanos(); \
+       code; report(label, (emu).stats() - before_, hostNanos() - t0_); } while (0)
+
+static void spiFraming(void)
+{
+  printf("SPI framing, cycles of one type share a CS assertion with burst on.\n");
+  printf("  Shapes are register writes, alternating command and data cycles, so they\n"
+         "  cost the same either way; only runs of data (text, pixels) gain:\n");
+
+  for (int burst = 1; burst >= 0; burst--)
+  {
+    // A fresh driver each time, so neither setting benefits from registers the other
+    //  left set
+    RA8876Emulator emu;
+    emu.attachSpi(12, 11);
+    RA8876SpiTransport spi(12);
+    RA8876 tft(&spi, 11);
+    tft.init();
+    tft.clearScreen(0);
+    spi.setBurst(burst);
+
+    printf(" burst %s\n", burst ? "on" : "off");
+    MEASURE(emu, "fillCircle", tft.fillCircle(300, 300, 40, 0xF800));
+    MEASURE(emu, "print", tft.print("Hello world"));
+    static uint16_t block[32 * 32];
+    MEASURE(emu, "32x32 pushPixels", tft.pushPixels(0, 0, 32, 32, block));
+  }
+}
+
+static void shapeRegisters(void)
+{
+  printf("Shape registers, unchanged coordinates and colours not rewritten (SPI):\n");
+
+  RA8876Emulator emu;
+  emu.attachSpi(12, 11);
+  RA8876 tft(12, 11);
+  tft.init();
+  tft.clearScreen(0);
+
+  RA8876EmulatorStats before = emu.stats();
+  for (int i = 0; i < 50; i++)
+    tft.drawLine(0, 10, 1000, 10 + i * 10, 0x07E0);
+  RA8876EmulatorStats d = emu.stats() - before;
+  printf("  fan of 50 lines from one point: %.1f bytes a line\n", d.busBytes / 50.0);
+}
+
+static void asyncPush(void)
+{
+  printf("Asynchronous push, rendering the next tile while the last one transfers:\n");
+
+  static uint16_t buf[2][1024 * 20];
+  for (int k = 0; k < 4; k++)
+  {
+    int      width = (k & 1) ? 16 : 8;
+    uint32_t ns    = (k & 2) ? 10 : 50;
+
+    for (int overlap = 0; overlap < 2; overlap++)
+    {
+      TestRig rig(width, 16, ns);
+      RA8876EmulatorStats before = rig.emu.stats();
+      uint64_t t0 = hostNanos();
+
+      rig.tft.beginPushAsync(0, 0, 1024, 600);
+      for (int tile = 0; tile < 30; tile++)
+      {
+        uint16_t *b = buf[tile & 1];
+        if (!overlap)
+          while (rig.tft.isPushBusy());
+        for (int i = 0; i < 1024 * 20; i++)
+          b[i] = i;
+        hostAdvance(1024 * 20 * 40);  // 40 ns a pixel to render
+        rig.tft.pushAsync(b, 1024 * 20, 0, 0);
+      }
+      rig.tft.endPushAsync();
+
+      RA8876EmulatorStats d = rig.emu.stats() - before;
+      printf("  %2d bit bus, %2u ns cycle, %-8s %6.1f ms, %llu FIFO overflows\n", width, (unsigned) ns,
+             overlap ? "overlap:" : "serial:", (hostNanos() - t0) / 1e6, (unsigned long long) d.fifoOverflows);
+    }
+  }
+}
+
+static void sprite(void)
+{
+  printf("Chroma-keyed sprite from SDRAM (SPI):\n");
+
+  RA8876Emulator emu;
+  emu.attachSpi(12, 11);
+  RA8876 tft(12, 11);
+  tft.init();
+  tft.clearScreen(0x1234);
+
+  SdramSurface sheet;
+  tft.allocSurface(64, 64, &sheet);
+  static uint16_t icon[32 * 32];
+  for (int i = 0; i < 32 * 32; i++)
+    icon[i] = (i % 3) ? 0xF800 : 0x07E0;
+  tft.setCanvasRegion(sheet.address, sheet.width);
+  tft.setCanvasWindow(0, 0, sheet.width, sheet.height);
+  tft.pushPixels(0, 0, 32, 32, icon);
+  tft.setCanvasRegion(0, 1024);
+  tft.setCanvasWindow(0, 0, 1024, 600);
+
+  MEASURE(emu, "32x32 icon", tft.drawSprite(sheet.address, sheet.width, 0, 0, 500, 300, 32, 32, 0x07E0));
+  MEASURE(emu, "32x32 pushPixels", tft.pushPixels(500, 300, 32, 32, icon));
+}
+
+static void pageFlip(void)
+{
+  printf("Page flipping, 10 frames (SPI):\n");
+
+  for (int k = 0; k < 3; k++)
+  {
+    int      pages  = (k == 0) ? 2 : 3;
+    uint64_t pollNs = (k == 2) ? 5000000 : 100000;
+
+    RA8876Emulator emu;
+    emu.attachSpi(12, 11);
+    RA8876 tft(12, 11);
+    tft.init();
+    tft.initPages(pages);
+
+    RA8876EmulatorStats before = emu.stats();
+    uint64_t t0 = hostNanos();
+    uint64_t longestPoll = 0;
+    int waits = 0;
+    for (int frame = 0; frame < 10; frame++)
+    {
+      tft.fillRect(0, 0, 1023, 599, frame);
+      tft.fillCircle(512, 300, 100 + frame, 0xFFFF);
+      if (pages == 3)
+      {
+        // Poll without blocking, then wait for VSYNC once polling has failed for a frame
+        tft.requestFlip();
+        uint64_t requested = hostNanos();
+        for (;;)
+        {
+          bool wait = (hostNanos() - requested > 20000000);
+          uint64_t start = hostNanos();
+          bool done = tft.updateFlip(wait);
+
+          if (wait)
+            waits++;
+          else
+            longestPoll = max(longestPoll, hostNanos() - start);
+
+          if (done)
+            break;
+          hostAdvance(pollNs);
+        }
+      }
+      else
+      {
+        tft.flip();
+      }
+    }
+    RA8876EmulatorStats d = emu.stats() - before;
+    printf("  %d pages, polled every %4d us: %6.1f ms, %llu tearing writes", pages, (int) (pollNs / 1000),
+           (hostNanos() - t0) / 1e6, (unsigned long long) d.tearingWrites);
+    if (pages == 3)
+      printf(", longest poll %llu us, %d blocking waits", (unsigned long long) (longestPoll / 1000), waits);
+    printf("\n");
+  }
+}
+
+static void displayList(void)
+{
+  printf("Display list, direct drawing against planned replay (16 bit bus):\n");
+
+  for (int mode = 0; mode < 2; mode++)
+  {
+    TestRig rig;
+    RA8876 &tft = rig.tft;
+    tft.clearScreen(0xAAAA);
+
+    RA8876DisplayList dl;
+    Print *p = mode ? (Print *) &dl : (Print *) &tft;
+#define DO(call) do { if (mode) dl.call; else tft.call; } while (0)
+    RA8876EmulatorStats before = rig.emu.stats();
+    uint64_t t0 = hostNanos();
+    DO(fillRect(0, 0, 200, 200, 0x1234));
+    DO(clearScreen(0x0000));
+    for (int i = 0; i < 6; i++)
+    {
+      DO(fillRect(10, 10 + i * 90, 500, 90 + i * 90, 0x001F));
+      DO(setTextColor(0xFFFF));
+      DO(setCursor(20, 20 + i * 90));
+      p->print("Sensor ");
+      p->print(i);
+      DO(fillCircle(700, 50 + i * 90, 30, 0xF800));
+      DO(setTextColor(0x07E0));
+      DO(setCursor(800, 40 + i * 90));
+      p->print(i * 17);
+    }
+#undef DO
+    if (mode)
+    {
+      before = rig.emu.stats();
+      t0 = hostNanos();
+      tft.drawList(&dl);
+    }
+    report(mode ? "replay" : "direct", rig.emu.stats() - before, hostNanos() - t0);
+  }
+}
+
+static void textStreaming(void)
+{
+  printf("Text, 30 lines of 66 characters, paced by FIFO depth:\n");
+
+  for (int spi = 0; spi < 2; spi++)
+  {
+    RA8876Emulator emu;
+    RA8876EmulatorTransport bus(&emu, 8);
+    emu.attachSpi(12, 11);
+    RA8876 *tft = spi ? new RA8876(12, 11) : new RA8876(&bus);
+    tft->init();
+    tft->clearScreen(0);
+    tft->setCursor(0, 0);
+
+    MEASURE(emu, spi ? "SPI" : "8 bit bus",
+            for (int line = 0; line < 30; line++)
+              tft->println("The quick brown fox jumps over the lazy dog 0123456789 ABCDEFGHIJ"));
+    delete tft;
+  }
+}
+
+static void glyphCache(void)
+{
+  printf("Glyph cache, a line of CJK text from the font ROM (8 bit bus):\n");
+
+  TestRig rig(8);
+  RA8876 &tft = rig.tft;
+  tft.clearScreen(0);
+  tft.selectExternalFont(RA8876_FONT_FAMILY_FIXED, RA8876_FONT_SIZE_24, RA8876_FONT_ENCODING_GB2312, RA8876_FONT_FLAG_UTF8);
+  tft.setUnicodeMap(ra8876Gb2312Map, RA8876_GB2312_MAP_SIZE);
+  const char *s = "\xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C\xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C";
+
+  tft.setCursor(0, 0);
+  MEASURE(rig.emu, "text engine", tft.print(s));
+
+  RA8876GlyphCache cache;
+  tft.setGlyphCache(&cache);
+  tft.setCursor(0, 100);
+  MEASURE(rig.emu, "cache, first use", tft.print(s));
+  tft.setCursor(0, 200);
+  MEASURE(rig.emu, "cache, all hits", tft.print(s));
+  tft.setGlyphCache(0);
+}
+
+static void bitmapGlyphs(void)
+{
+  printf("Bitmap font glyphs by colour expansion, line of 16 (16 bit bus):\n");
+
+  for (int bpp = 1; bpp <= 4; bpp *= 2)
+  {
+    TestRig rig;
+    RA8876 &tft = rig.tft;
+    tft.clearScreen(0);
+
+    TestFont tf(bpp, 1);
+    RA8876FontAtlas atlas;
+    tft.loadFont(&tf.font, &atlas);
+    tft.selectBitmapFont(&atlas, 0);
+    tft.setTextColor(0xFFFF);
+    tft.setCursor(0, 100);
+
+    char label[32];
+    snprintf(label, sizeof label, "%d bpp", bpp);
+    MEASURE(rig.emu, label, tft.print("ABCDABCDABCDABCD"));
+    tft.freeFont(&atlas);
+  }
+}
+
+static void textBox(void)
+{
+  printf("Text box, 100 lines scrolled through a 4 line box (16 bit bus):\n");
+
+  TestRig rig;
+  rig.tft.clearScreen(0);
+  rig.tft.selectInternalFont(RA8876_FONT_SIZE_16);
+  RA8876TextBox box(&rig.tft, 100, 40, 200, 64);
+  box.clear();
+
+  MEASURE(rig.emu, "100 lines",
+          for (int i = 0; i < 100; i++)
+          {
+            box.print("log entry number ");
+            box.println(i);
+          });
+}
+
+static void terminal(void)
+{
+  printf("Terminal, 1000 lines (16 bit bus):\n");
+
+  TestRig rig;
+  rig.tft.clearScreen(0);
+  rig.tft.selectInternalFont(RA8876_FONT_SIZE_16);
+  RA8876Terminal term(&rig.tft);
+  term.begin();
+
+  RA8876EmulatorStats before = rig.emu.stats();
+  uint64_t t0 = hostNanos();
+  for (int i = 0; i < 1000; i++)
+  {
+    term.print("log entry number ");
+    term.println(i);
+  }
+  uint64_t ns = hostNanos() - t0;
+  RA8876EmulatorStats d = rig.emu.stats() - before;
+  report("1000 lines", d, ns);
+  printf("  %.0f lines a second, %llu BTE copies\n", 1000 / (ns / 1e9), (unsigned long long) d.blits);
+}
+
+int main()
+{
+  spiFraming();
+  shapeRegisters();
+  asyncPush();
+  sprite();
+  pageFlip();
+  displayList();
+  textStreaming();
+  glyphCache();
+  bitmapGlyphs();
+  textBox();
+  terminal();
+
+  return 0;
+}
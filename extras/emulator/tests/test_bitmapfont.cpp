@@ -0,0 +1,165 @@
+// Bitmap fonts: anti-aliased glyphs at each coverage depth, checked pixel by pixel
+//  against a software blend, with kerning and line breaks; and text in a bitmap font
+//  replayed from a display list.
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "RA8876Test.h"
+#include "TestFont.h"
+
+// The colour a pixel at the given coverage level should get, blending in 8-bit RGB
+//  and reducing to the display depth.
+static uint32_t blend(int bpp, int level, uint32_t fg, int depth)
+{
+  int top = (1 << bpp) - 1;
+  uint32_t rgb = 0;
+  for (int s = 0; s < 24; s += 8)
+    rgb |= ((((fg >> s) & 0xFF) * level + (top / 2)) / top) << s;
+
+  uint8_t r = rgb >> 16, g = rgb >> 8, b = rgb;
+  if (depth == 16)
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+
+  return (r & 0xE0) | ((g & 0xE0) >> 3) | (b >> 6);
+}
+
+static void run(int bpp, int depth, bool async, int busWidth)
+{
+  TestRig rig(busWidth, depth);
+  RA8876 &tft = rig.tft;
+  CHECK(rig.ready);
+  tft.clearScreen(0);
+
+  TestFont tf(bpp, 77 + bpp);
+  RA8876FontAtlas atlas;
+  CHECK(tft.loadFont(&tf.font, &atlas));
+  tft.setAsyncDrawing(async);
+  tft.selectBitmapFont(&atlas, RGB565(0, 0, 0));
+  uint16_t color = RGB565(255, 128, 64);
+  tft.setTextColor(color);
+  tft.setCursor(10, 20);
+
+  const char *s = "ABCDAB\nBA";
+  tft.print(s);
+  tft.waitIdle();
+
+  // Expand the RGB565 text colour to 8 bits a channel, as the blend does
+  uint8_t r = (color >> 11) << 3, g = ((color >> 5) & 0x3F) << 2, b = (color & 0x1F) << 3;
+  uint32_t fg = ((uint32_t) (r | (r >> 5)) << 16) | ((g | (g >> 6)) << 8) | (b | (b >> 5));
+
+  // Where glyphs overlap, the higher coverage shows
+  std::map<std::pair<int, int>, int> levels;
+  int x = 10, y = 20, left = 0;
+  for (const char *p = s; *p; p++)
+  {
+    if (*p == '\n')
+    {
+      x = 0;
+      y += 40;
+      left = 0;
+      continue;
+    }
+
+    if ((left == 'A') && (*p == 'B'))
+      x -= 3;
+    if ((left == 'B') && (*p == 'A'))
+      x += 2;
+
+    int i = *p - 'A';
+    const RA8876Glyph &glyph = tf.glyphs[i];
+    for (int gy = 0; gy < glyph.height; gy++)
+      for (int gx = 0; gx < glyph.width; gx++)
+      {
+        int level = tf.coverage[i][gy * glyph.width + gx];
+        if (level)
+        {
+          int &at = levels[std::make_pair(x + glyph.xOffset + gx, y + 32 + glyph.yOffset + gy)];
+          at = std::max(at, level);
+        }
+      }
+
+    x += glyph.xAdvance;
+    left = *p;
+  }
+
+  int bad = 0;
+  for (auto &e : levels)
+    if (rig.emu.canvasPixel(e.first.first, e.first.second) != blend(bpp, e.second, fg, depth))
+      bad++;
+  if (bad)
+    printf("%d bpp at depth %d: %d pixels wrong\n", bpp, depth, bad);
+  CHECK_EQ(bad, 0);
+
+  CHECK_EQ(tft.getCursorX(), x);
+  CHECK_EQ(tft.getCursorY(), y);
+  CHECK_EQ(tft.measureText("ABCDAB"), (7 + 14 + 21 + 28 + 7 + 14) - 3 - 3);
+
+  // Kerning belongs to the glyph after the pair, and only if it stays on the line. In
+  //  21 pixels, "BA" needs 14 + 2 + 7, so the A wraps, unkerned, and the B after it is
+  //  kerned against it on the new line. fitText() must break in the same place.
+  size_t next;
+  CHECK_EQ(tft.fitText("BAB", 3, 21, &next), 1);
+  CHECK_EQ(next, 1);
+  tft.setCanvasWindow(500, 300, 21, 200);
+  tft.setCursor(500, 300);
+  tft.print("BAB");
+  CHECK_EQ(tft.getCursorX(), 500 + 7 - 3 + 14);
+  CHECK_EQ(tft.getCursorY(), 340);
+  tft.setCanvasWindow(0, 0, 1024, 600);
+  CHECK(rig.clean());
+
+  tft.freeFont(&atlas);
+}
+
+// The same text drawn directly and from a display list, over a ROM font selection
+//  that the replay must not fall back to.
+static void replay(void)
+{
+  TestRig rig[2];
+  for (int mode = 0; mode < 2; mode++)
+  {
+    RA8876 &tft = rig[mode].tft;
+    tft.clearScreen(0);
+
+    static TestFont tf(2, 5);
+    RA8876FontAtlas atlas;
+    CHECK(tft.loadFont(&tf.font, &atlas));
+    tft.selectExternalFont(RA8876_FONT_FAMILY_FIXED, RA8876_FONT_SIZE_32, RA8876_FONT_ENCODING_8859_1);
+    tft.selectBitmapFont(&atlas, 0);
+
+    if (mode)
+    {
+      RA8876DisplayList dl;
+      dl.fillRect(0, 0, 300, 100, 0x001F);
+      dl.setTextColor(0xFFFF);
+      dl.setCursor(10, 10);
+      dl.print("ABCD");
+      tft.drawList(&dl);
+    }
+    else
+    {
+      tft.fillRect(0, 0, 300, 100, 0x001F);
+      tft.setTextColor(0xFFFF);
+      tft.setCursor(10, 10);
+      tft.print("ABCD");
+    }
+
+    CHECK(rig[mode].emu.textLog().empty());  // No ROM text
+  }
+
+  CHECK_EQ(rig[1].diffDisplay(rig[0], 0, 0, 400, 120), 0);
+}
+
+int main()
+{
+  run(1, 16, false, 8);
+  run(2, 16, true, 16);
+  run(4, 16, false, 8);
+  run(1, 8, true, 8);
+  run(2, 8, false, 16);
+  replay();
+
+  return testExit("test_bitmapfont");
+}
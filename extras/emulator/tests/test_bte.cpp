@@ -0,0 +1,73 @@
+// BTE copies within one image, overlapping in every direction, checked pixel by pixel
+//  against a software copy.
+
+#include <string.h>
+
+#include "RA8876Test.h"
+
+static uint16_t ref[600][1024];
+static uint16_t tmp[600][1024];
+
+int main()
+{
+  RA8876Emulator emu;
+  emu.attachSpi(12, 11);
+  RA8876 tft(12, 11);
+  CHECK(tft.init());
+
+  static uint16_t img[600 * 1024];
+  for (int i = 0; i < 1024 * 600; i++)
+    img[i] = i * 7 + (i >> 10);
+  tft.pushPixels(0, 0, 1024, 600, img);
+  memcpy(ref, img, sizeof ref);
+
+  // Source and destination corners, and size
+  static const struct { int sx, sy, dx, dy, w, h; } cases[] =
+  {
+    {  10,  10,  15,  40,  300, 200 },  // Down and right
+    {  10,  10,  50,  10,  300, 200 },  // Right, same rows
+    { 100, 100,  90,  60,  300, 200 },  // Up and left
+    { 100, 100,  60, 100,  200,  50 },  // Left, same rows
+    {   0,   0, 500, 300,  100, 100 },  // Apart
+    {   0,   1,   0,   0, 1024, 599 },  // Whole screen up a row
+    {   0,   0,   0,   1, 1024, 599 },  // Whole screen down a row
+  };
+
+  for (size_t k = 0; k < sizeof cases / sizeof cases[0]; k++)
+  {
+    const int sx = cases[k].sx, sy = cases[k].sy, dx = cases[k].dx, dy = cases[k].dy;
+    const int w = cases[k].w, h = cases[k].h;
+
+    CHECK(tft.bteCopy(0, 1024, sx, sy, 0, 1024, dx, dy, w, h));
+
+    for (int y = 0; y < h; y++)
+      for (int x = 0; x < w; x++)
+        tmp[y][x] = ref[sy + y][sx + x];
+    for (int y = 0; y < h; y++)
+      for (int x = 0; x < w; x++)
+        ref[dy + y][dx + x] = tmp[y][x];
+
+    int bad = 0;
+    for (int y = 0; y < 600; y++)
+      for (int x = 0; x < 1024; x++)
+        if (emu.displayPixel(x, y) != ref[y][x])
+          bad++;
+    if (bad)
+      printf("case %d: %d pixels wrong\n", (int) k, bad);
+    CHECK_EQ(bad, 0);
+  }
+
+  // Raster operation applied; unaligned address refused
+  CHECK(tft.bteCopy(0, 1024, 0, 0, 0, 1024, 0, 0, 10, 10, RA8876_ROP_XOR));
+  CHECK_EQ(emu.displayPixel(5, 5), 0);
+  CHECK(!tft.bteCopy(2, 1024, 0, 0, 0, 1024, 0, 0, 10, 10));
+
+  // Asynchronous: drawing after a copy waits for it
+  tft.setAsyncDrawing(true);
+  CHECK(tft.bteCopy(0, 1024, 0, 0, 0, 1024, 0, 100, 1024, 100));
+  tft.fillRect(0, 0, 3, 3, 0xFFFF);
+  tft.waitIdle();
+  CHECK_EQ(emu.stats().busyViolations, 0);
+
+  return testExit("test_bte");
+}
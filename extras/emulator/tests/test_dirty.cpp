@@ -0,0 +1,113 @@
+// Dirty rectangle tracker: merging of nearby and overlapping rectangles, keeping
+//  distant ones apart, and a full table.
+
+#include "RA8876Test.h"
+#include "TestFont.h"
+
+static bool same(const DirtyRect *r, int x1, int y1, int x2, int y2)
+{
+  return (r->x1 == x1) && (r->y1 == y1) && (r->x2 == x2) && (r->y2 == y2);
+}
+
+int main()
+{
+  RA8876DirtyTracker dirty;
+
+  // Corners are normalised
+  dirty.add(20, 30, 10, 5);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 10, 5, 20, 30));
+  CHECK_EQ(dirty.area(), 11 * 26);
+
+  // Contained and edge-sharing rectangles merge when the union costs nothing extra
+  dirty.add(12, 6, 15, 8);
+  dirty.add(21, 5, 30, 30);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 10, 5, 30, 30));
+
+  // Touching at a corner adds a few pixels, which is cheaper than a second copy
+  dirty.add(31, 31, 40, 40);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 10, 5, 40, 40));
+
+  // Offset overlaps merge: the union only adds the two corners neither covers
+  dirty.clear();
+  dirty.add(0, 0, 99, 99);
+  dirty.add(10, 10, 109, 109);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 0, 0, 109, 109));
+
+  // But not once the corners are bigger than a copy is worth
+  dirty.clear();
+  dirty.add(0, 0, 99, 99);
+  dirty.add(50, 50, 149, 149);
+  CHECK_EQ(dirty.count(), 2);
+
+  // Far apart stays separate
+  dirty.clear();
+  dirty.add(0, 0, 9, 9);
+  dirty.add(100, 100, 109, 109);
+  CHECK_EQ(dirty.count(), 2);
+  CHECK_EQ(dirty.area(), 200);
+
+  // A rectangle bridging two others absorbs both once it makes them cheaper together
+  dirty.clear();
+  dirty.add(0, 0, 9, 9);
+  dirty.add(20, 0, 29, 9);
+  dirty.add(10, 0, 19, 9);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 0, 0, 29, 9));
+
+  // Full table: new rectangles are folded into the one that grows least, and nothing
+  //  added is lost
+  dirty.clear();
+  for (int i = 0; i < RA8876_MAX_DIRTY_RECTS; i++)
+    dirty.add((i % 4) * 200, (i / 4) * 150, (i % 4) * 200 + 9, (i / 4) * 150 + 9);
+  CHECK_EQ(dirty.count(), RA8876_MAX_DIRTY_RECTS);
+  dirty.add(500, 500, 505, 505);
+  CHECK_EQ(dirty.count(), RA8876_MAX_DIRTY_RECTS);
+  bool covered = false;
+  for (int i = 0; i < dirty.count(); i++)
+  {
+    const DirtyRect *r = dirty.rect(i);
+    if ((r->x1 <= 500) && (r->y1 <= 500) && (r->x2 >= 505) && (r->y2 >= 505))
+    {
+      covered = true;
+      CHECK(same(r, 400, 450, 505, 505));
+    }
+  }
+  CHECK(covered);
+
+  // Driver: drawing reports the area it touched
+  TestRig rig;
+  rig.tft.setDirtyTracker(&dirty);
+  dirty.clear();
+  rig.tft.fillRect(30, 40, 10, 20, 0xFFFF);
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 10, 20, 30, 40));
+  rig.tft.fillCircle(500, 300, 20, 0xFFFF);
+  CHECK_EQ(dirty.count(), 2);
+  CHECK(same(dirty.rect(1), 480, 280, 520, 320));
+
+  // Text engine output is marked from the cursor before and after
+  dirty.clear();
+  rig.tft.selectInternalFont(RA8876_FONT_SIZE_16);
+  rig.tft.setCursor(100, 400);
+  rig.tft.print("Hi");
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 100, 400, 115, 415));
+
+  // Bitmap glyphs are marked as each is drawn, just covering their pixels
+  TestFont tf(1, 3);
+  RA8876FontAtlas atlas;
+  CHECK(rig.tft.loadFont(&tf.font, &atlas));
+  rig.tft.selectBitmapFont(&atlas, 0);
+  dirty.clear();
+  rig.tft.setCursor(100, 100);
+  rig.tft.print("AB");
+  CHECK_EQ(dirty.count(), 1);
+  CHECK(same(dirty.rect(0), 99, 122, 115, 133));
+  CHECK(rig.clean());
+
+  return testExit("test_dirty");
+}
@@ -0,0 +1,146 @@
+// Display list planner: replaying a recorded scene must give the same image as
+//  drawing it directly, while operations hidden under later fills are dropped. Text
+//  bounds must allow for bitmap glyphs wider than the line is high, and for wrapping
+//  at the edge of the canvas window.
+
+#include "RA8876Test.h"
+#include "TestFont.h"
+
+static void scene(Print *p, RA8876 *tft, RA8876DisplayList *dl)
+{
+#define DO(call) do { if (dl) dl->call; else tft->call; } while (0)
+  DO(fillRect(0, 0, 200, 200, 0x1234));      // Covered by the clear
+  DO(drawLine(5, 5, 100, 100, 0xFFFF));      // Covered by the clear
+  DO(clearScreen(0x0000));
+  DO(fillRect(10, 10, 300, 60, 0x001F));
+  DO(setTextColor(0xFFFF));
+  DO(setCursor(20, 20));
+  p->print("Temp");
+  DO(fillCircle(500, 300, 40, 0xF800));
+  DO(setCursor(20, 100));
+  p->print("Humidity");
+  DO(drawLine(0, 400, 1023, 400, 0xFFFF));
+  DO(fillCircle(700, 300, 40, 0xF800));
+  DO(setTextColor(0x07E0));
+  DO(setCursor(400, 500));
+  p->print(42);
+  DO(drawRect(800, 100, 900, 200, 0xFFFF));
+  DO(fillCircle(900, 300, 40, 0xF800));
+  DO(fillRect(600, 500, 700, 550, 0x07E0));
+  DO(fillRect(610, 510, 620, 520, 0x001F));  // Covered by the next fill
+  DO(fillRect(600, 500, 700, 550, 0x07E0));
+#undef DO
+}
+
+// Text partly painted over by a later fill: the planner must see that the text reaches
+//  past the fill, and keep it.
+static void textScene(Print *p, RA8876 *tft, RA8876DisplayList *dl, bool wrap)
+{
+#define DO(call) do { if (dl) dl->call; else tft->call; } while (0)
+  DO(setTextColor(0xFFFF));
+  if (wrap)
+  {
+    // Wraps within the window onto a second line that the fill misses
+    DO(setCursor(100, 300));
+    p->print("Wrapping text within the window");
+    DO(fillRect(100, 300, 600, 315, 0x07E0));
+  }
+  else
+  {
+    DO(setCursor(100, 100));
+    p->print("DDDD");
+    DO(fillRect(100, 100, 180, 119, 0x001F));
+  }
+#undef DO
+}
+
+static void textBounds(void)
+{
+  TestRig direct, replay;
+  CHECK(direct.ready && replay.ready);
+
+  // Glyphs up to 28 pixels wide, on lines 20 high
+  TestFont tf(1, 3);
+  tf.font.yAdvance = 20;
+  tf.font.baseline = 18;
+
+  RA8876FontAtlas directFont, replayFont;
+  CHECK(direct.tft.loadFont(&tf.font, &directFont));
+  CHECK(replay.tft.loadFont(&tf.font, &replayFont));
+  CHECK_EQ(replayFont.maxAdvance(), 30);
+
+  for (int wrap = 0; wrap < 2; wrap++)
+  {
+    TestRig *rigs[2] = { &direct, &replay };
+    for (int i = 0; i < 2; i++)
+    {
+      RA8876 &tft = rigs[i]->tft;
+      tft.clearScreen(0x0000);
+      if (wrap)
+      {
+        tft.selectInternalFont(RA8876_FONT_SIZE_16);
+        tft.setCanvasWindow(100, 300, 200, 100);
+      }
+      else
+      {
+        tft.selectBitmapFont(i ? &replayFont : &directFont, 0x0000);
+      }
+    }
+
+    textScene(&direct.tft, &direct.tft, 0, wrap);
+
+    RA8876DisplayList dl;
+    textScene(&dl, &replay.tft, &dl, wrap);
+    replay.tft.drawList(&dl);
+
+    CHECK_EQ(replay.diffDisplay(direct, 0, 0, 1024, 600), 0);
+  }
+
+  CHECK(direct.clean() && replay.clean());
+}
+
+int main()
+{
+  TestRig direct, replay;
+  CHECK(direct.ready && replay.ready);
+  direct.tft.clearScreen(0xAAAA);
+  replay.tft.clearScreen(0xAAAA);
+
+  scene(&direct.tft, &direct.tft, 0);
+
+  RA8876DisplayList dl;
+  scene(&dl, &replay.tft, &dl);
+  CHECK(!dl.overflowed());
+  CHECK_EQ(dl.count(), 15);
+  replay.tft.drawList(&dl);
+
+  CHECK_EQ(replay.diffDisplay(direct, 0, 0, 1024, 600), 0);
+  CHECK(direct.clean() && replay.clean());
+
+  // The two shapes under the clear and the first two fills at the bottom are gone,
+  //  and the text is grouped so the mode changes once
+  DirtyRect screen = { 0, 0, 1023, 599 };
+  int planned = dl.plan(replay.tft.getTextSizeY(), replay.tft.getTextSizeY(), 0, &screen);
+  CHECK_EQ(planned, dl.count() - 4);
+  int modeChanges = 0;
+  for (int i = 0; i < planned; i++)
+  {
+    CHECK((dl.planOp(i)->color != 0x1234) && (dl.planOp(i)->color != 0x001F || dl.planOp(i)->x1 == 10));
+    if ((i > 0) && ((dl.planOp(i)->type == RA8876_OP_TEXT) != (dl.planOp(i - 1)->type == RA8876_OP_TEXT)))
+      modeChanges++;
+  }
+  CHECK_EQ(modeChanges, 1);
+
+  // Replay is cheaper on the bus than drawing the same scene
+  CHECK(replay.emu.stats().shapes < direct.emu.stats().shapes);
+
+  // Overflow is reported rather than dropping operations silently
+  RA8876DisplayList full;
+  for (int i = 0; i <= RA8876_DISPLAY_LIST_OPS; i++)
+    full.fillRect(i, 0, i, 0, 0xFFFF);
+  CHECK(full.overflowed());
+
+  textBounds();
+
+  return testExit("test_displaylist");
+}
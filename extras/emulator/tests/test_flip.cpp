@@ -0,0 +1,76 @@
+// Page flipping with two and three pages, polled promptly and late: every frame shown
+//  must be complete, with no drawing to the page on display, and updateFlip() must
+//  not block unless asked to.
+
+#include "RA8876Test.h"
+
+static void run(int pages, uint64_t pollNs)
+{
+  RA8876Emulator emu;
+  emu.attachSpi(12, 11);
+  RA8876 tft(12, 11);
+  CHECK(tft.init());
+  CHECK(tft.initPages(pages));
+
+  RA8876EmulatorStats before = emu.stats();
+  uint64_t longestPoll = 0;
+  int waits = 0;
+  for (int frame = 0; frame < 10; frame++)
+  {
+    tft.fillRect(0, 0, 1023, 599, frame);
+    tft.fillCircle(512, 300, 100 + frame, 0xFFFF);
+
+    if (pages == 3)
+    {
+      // Drawing could carry on into the third page while polling. A late poller may
+      //  keep missing blanking, so after more than a frame it waits for the next VSYNC.
+      tft.requestFlip();
+      uint64_t requested = hostNanos();
+      for (;;)
+      {
+        bool wait = (hostNanos() - requested > 20000000);
+        uint64_t start = hostNanos();
+        bool done = tft.updateFlip(wait);
+
+        if (wait)
+          waits++;
+        else
+          longestPoll = max(longestPoll, hostNanos() - start);
+
+        if (done)
+          break;
+        hostAdvance(pollNs);
+      }
+    }
+    else
+    {
+      tft.flip();
+    }
+
+    CHECK_EQ(emu.displayPixel(0, 0), frame);
+    CHECK_EQ(emu.displayPixel(512, 300), 0xFFFF);
+  }
+
+  RA8876EmulatorStats d = emu.stats() - before;
+  if (d.tearingWrites)
+    printf("%d pages, polled every %d us: %llu tearing writes\n", pages, (int) (pollNs / 1000), (unsigned long long) d.tearingWrites);
+  CHECK_EQ(d.tearingWrites, 0);
+
+  // A poll is a few register accesses, far short of a frame
+  CHECK(longestPoll < 500000);
+  if (pollNs < 1000 * tft.blankingMicros())
+    CHECK_EQ(waits, 0);
+}
+
+int main()
+{
+  run(2, 100000);
+  run(3, 100000);
+  run(3, 5000000);  // Slower than the blanking interval
+
+  // Not enough SDRAM for the pages asked for
+  TestRig rig;
+  CHECK(!rig.tft.initPages(100));
+
+  return testExit("test_flip");
+}
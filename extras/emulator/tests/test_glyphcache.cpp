@@ -0,0 +1,76 @@
+// Glyph cache: text drawn from the cache must match the text engine's, on 8- and
+//  16-bit buses at both canvas depths, with the second pass all hits; and the cache
+//  evicts the least recently used glyph.
+
+#include "RA8876Test.h"
+
+// Canvas pixels that differ between two rows of text.
+static int diffRows(RA8876Emulator &emu, int y1, int y2, int width, int height)
+{
+  int diff = 0;
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      if (emu.canvasPixel(x, y1 + y) != emu.canvasPixel(x, y2 + y))
+        diff++;
+
+  return diff;
+}
+
+static void run(int busWidth, int depth)
+{
+  TestRig rig(busWidth, depth);
+  RA8876 &tft = rig.tft;
+  CHECK(rig.ready);
+
+  tft.clearScreen(0);
+  tft.setTextColor(RGB565(255, 255, 0));
+  tft.selectExternalFont(RA8876_FONT_FAMILY_FIXED, RA8876_FONT_SIZE_24, RA8876_FONT_ENCODING_GB2312, RA8876_FONT_FLAG_UTF8);
+  tft.setUnicodeMap(ra8876Gb2312Map, RA8876_GB2312_MAP_SIZE);
+
+  const char *s = "Hello \xE4\xBD\xA0\xE5\xA5\xBD world \xE4\xBD\xA0!";
+
+  // The text engine, for reference
+  tft.setCursor(0, 0);
+  tft.print(s);
+  int endX = tft.getCursorX();
+
+  RA8876GlyphCache cache;
+  CHECK(tft.setGlyphCache(&cache));
+
+  tft.setCursor(0, 100);
+  tft.print(s);
+  CHECK_EQ(tft.getCursorX(), endX);
+  CHECK_EQ(diffRows(rig.emu, 0, 100, 1024, 24), 0);
+
+  // Every glyph is now cached, so the text engine is left alone
+  unsigned int misses = cache.misses();
+  rig.emu.clearTextLog();
+  tft.setCursor(0, 200);
+  tft.print(s);
+  CHECK_EQ(cache.misses(), misses);
+  CHECK(rig.emu.textLog().empty());
+  CHECK_EQ(diffRows(rig.emu, 0, 200, 1024, 24), 0);
+
+  tft.waitIdle();
+  CHECK(rig.clean());
+}
+
+int main()
+{
+  run(8, 16);
+  run(16, 16);  // One read cycle per pixel
+  run(8, 8);
+  run(16, 8);
+
+  // The glyph used least recently goes first
+  RA8876GlyphCache cache;
+  for (int i = 0; i < RA8876_GLYPH_CACHE_SLOTS; i++)
+    cache.insert(i, 8);
+  cache.find(0);
+  int slot = cache.insert(999, 8);
+  CHECK(cache.find(1) < 0);
+  CHECK(cache.find(0) >= 0);
+  CHECK_EQ(cache.find(999), slot);
+
+  return testExit("test_glyphcache");
+}
@@ -0,0 +1,72 @@
+// RA8876ParallelTransport driven through the GPIO shim, in each bus mode: every cycle
+//  must be made with the chip selected, including those the driver makes after a
+//  nested transaction (a newline moving the cursor, a display list replaying text,
+//  text reporting its area to a dirty tracker).
+
+#include "RA8876Test.h"
+
+static const int dataPins[16] = { 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35 };
+
+enum { CS_PIN = 10, A0_PIN, STROBE_PIN, READ_PIN };
+
+// The same drawing on any driver.
+static void draw(RA8876 &tft)
+{
+  RA8876DirtyTracker dirty;
+
+  tft.clearScreen(0);
+  tft.fillRect(10, 10, 200, 100, 0x001F);
+  tft.selectInternalFont(RA8876_FONT_SIZE_16);
+  tft.setTextColor(0xFFFF);
+  tft.setCursor(20, 20);
+  tft.print("ab\ncd");
+
+  RA8876DisplayList dl;
+  dl.drawLine(0, 300, 500, 350, 0xF800);
+  dl.setCursor(300, 200);
+  dl.print("ef\ngh");
+  dl.fillRect(600, 300, 700, 400, 0x07E0);
+  tft.drawList(&dl);
+
+  tft.setDirtyTracker(&dirty);
+  tft.setCursor(20, 400);
+  tft.print("ij");
+  tft.setDirtyTracker(0);
+}
+
+static void run(enum ParallelBusMode mode, int width)
+{
+  RA8876Emulator emu;
+  emu.attachParallel(mode, width, dataPins, CS_PIN, A0_PIN, STROBE_PIN, READ_PIN);
+  RA8876ParallelTransport bus(mode, width, dataPins, CS_PIN, A0_PIN, STROBE_PIN, READ_PIN);
+  RA8876 tft(&bus);
+
+  CHECK(tft.init());
+  draw(tft);
+
+  TestRig ref(width);
+  draw(ref.tft);
+
+  CHECK_EQ(emu.stats().deselectedCycles, 0);
+  CHECK(emu.textLog() == ref.emu.textLog());
+
+  int diff = 0;
+  for (int y = 0; y < 600; y++)
+    for (int x = 0; x < 1024; x++)
+      if (emu.displayPixel(x, y) != ref.emu.displayPixel(x, y))
+        diff++;
+  if (diff)
+    printf("%s %d bit: %d pixels differ\n", (mode == RA8876_BUS_8080) ? "8080" : "6800", width, diff);
+  CHECK_EQ(diff, 0);
+  CHECK(ref.clean());
+}
+
+int main()
+{
+  run(RA8876_BUS_8080, 8);
+  run(RA8876_BUS_8080, 16);
+  run(RA8876_BUS_6800, 8);
+  run(RA8876_BUS_6800, 16);
+
+  return testExit("test_parallel");
+}
@@ -0,0 +1,58 @@
+// Asynchronous pixel pushes on 8 and 16 bit buses, with transfers slower and faster
+//  than the controller takes data: every callback runs, the write FIFO never
+//  overflows, and the image arrives intact.
+
+#include "RA8876Test.h"
+
+static int done;
+
+static void pushed(void *context)
+{
+  done += *(int *) context;
+}
+
+static void run(int busWidth, uint32_t cycleNs)
+{
+  TestRig rig(busWidth, 16, cycleNs);
+  CHECK(rig.ready);
+
+  static uint16_t buf[2][1024 * 20];
+  int one = 1;
+  done = 0;
+
+  CHECK(rig.tft.beginPushAsync(0, 0, 1024, 600));
+  for (int tile = 0; tile < 30; tile++)
+  {
+    uint16_t *b = buf[tile & 1];
+    for (int i = 0; i < 1024 * 20; i++)
+      b[i] = (tile * 1024 * 20 + i) * 3;
+    hostAdvance(1024 * 20 * 40);  // Rendering time
+    rig.tft.pushAsync(b, 1024 * 20, pushed, &one);
+  }
+  rig.tft.endPushAsync();
+
+  CHECK_EQ(done, 30);
+  CHECK_EQ(rig.emu.stats().fifoOverflows, 0);
+
+  int bad = 0;
+  for (int i = 0; i < 1024 * 600; i++)
+    if (rig.emu.displayPixel(i % 1024, i / 1024) != (uint16_t) (i * 3))
+      bad++;
+  if (bad)
+    printf("%d bit bus at %u ns: %d pixels wrong\n", busWidth, (unsigned) cycleNs, bad);
+  CHECK_EQ(bad, 0);
+
+  // Ordinary drawing works afterwards
+  rig.tft.fillRect(0, 0, 5, 5, 0xFFFF);
+  CHECK_EQ(rig.emu.displayPixel(3, 3), 0xFFFF);
+}
+
+int main()
+{
+  run(8, 50);
+  run(16, 50);
+  run(8, 10);
+  run(16, 10);
+
+  return testExit("test_push");
+}
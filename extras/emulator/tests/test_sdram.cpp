@@ -0,0 +1,89 @@
+// SDRAM allocator: first fit, splitting, merging on free, resizing in place, and
+//  a full block table.
+
+#include "RA8876Test.h"
+
+int main()
+{
+  RA8876SdramAllocator sdram;
+  sdram.begin(1000);
+
+  CHECK_EQ(sdram.freeBytes(), 1000);
+  CHECK_EQ(sdram.alloc(0), RA8876_SDRAM_NONE);
+  CHECK_EQ(sdram.alloc(1001), RA8876_SDRAM_NONE);
+
+  // Sizes round up to a multiple of 4
+  uint32_t a = sdram.alloc(99);
+  uint32_t b = sdram.alloc(100);
+  uint32_t c = sdram.alloc(100);
+  CHECK_EQ(a, 0);
+  CHECK_EQ(b, 100);
+  CHECK_EQ(c, 200);
+  CHECK_EQ(sdram.freeBytes(), 700);
+
+  // A freed hole is reused first if it fits, and merges with free neighbours
+  sdram.free(b);
+  CHECK_EQ(sdram.largestFree(), 700);
+  CHECK_EQ(sdram.alloc(40), 100);
+  sdram.free(100);
+  sdram.free(a);
+  CHECK_EQ(sdram.largestFree(), 700);
+  CHECK_EQ(sdram.alloc(200), 0);
+  sdram.free(0);
+  sdram.free(c);
+  CHECK_EQ(sdram.largestFree(), 1000);
+
+  // Freeing something that is not allocated does nothing
+  sdram.free(0);
+  sdram.free(12);
+  CHECK_EQ(sdram.freeBytes(), 1000);
+
+  // Resize grows into a free block that follows, and shrinks, returning the space
+  a = sdram.alloc(100);
+  CHECK(sdram.resize(a, 300));
+  CHECK_EQ(sdram.alloc(100), 300);
+  CHECK(!sdram.resize(a, 304));            // Next block now in use
+  CHECK(sdram.resize(a, 200));             // Shrinking splits off a free block
+  CHECK_EQ(sdram.alloc(100), 200);
+  CHECK(!sdram.resize(a, 204));
+  CHECK(!sdram.resize(500, 100));          // Not allocated
+  sdram.free(300);
+  CHECK(sdram.resize(200, 800));           // Exactly the rest
+  CHECK_EQ(sdram.freeBytes(), 0);
+  CHECK(!sdram.resize(200, 804));
+
+  // Allocation fails rather than splitting when the block table is full
+  sdram.begin(4 * (RA8876_SDRAM_MAX_BLOCKS + 10));
+  a = sdram.alloc(8);
+  int n = 1;
+  while (sdram.alloc(4) != RA8876_SDRAM_NONE)
+    n++;
+  CHECK_EQ(n, RA8876_SDRAM_MAX_BLOCKS - 1);
+  CHECK_EQ(sdram.freeBytes(), 4 * 10);
+  CHECK(sdram.alloc(4 * 10) != RA8876_SDRAM_NONE);  // Exact fit needs no new entry
+  // Shrinking a block with a used neighbour needs a new entry too
+  CHECK(!sdram.resize(a, 4));
+
+  // Driver: surfaces go after the frame buffer, which follows the display depth
+  TestRig rig;
+  CHECK(rig.ready);
+  SdramSurface s;
+  CHECK(rig.tft.allocSurface(100, 100, &s));
+  CHECK_EQ(s.address, 1024u * 600 * 2);
+  CHECK(!rig.tft.setDisplayDepth(24));     // Would overlap the surface
+  CHECK(rig.tft.setDisplayDepth(8));
+  SdramSurface t;
+  CHECK(rig.tft.allocSurface(100, 100, &t));
+  CHECK_EQ(t.address, 1024u * 600);
+  CHECK(!rig.tft.setDisplayDepth(16));
+  rig.tft.freeSurface(&t);
+  CHECK(rig.tft.setDisplayDepth(16));
+
+  // With pages reserved, the frame buffer can no longer grow
+  TestRig paged;
+  CHECK(paged.tft.initPages(2));
+  CHECK(!paged.tft.setDisplayDepth(24));
+  CHECK(paged.tft.setDisplayDepth(8));
+
+  return testExit("test_sdram");
+}
@@ -0,0 +1,90 @@
+// Scrolling terminal: after many lines, including trips round the ring, the screen
+//  must match a terminal that was only given the last screenful. Also line wrapping,
+//  carriage returns overwriting text, and the driver's own state left alone.
+
+#include <RA8876Terminal.h>
+
+#include "RA8876Test.h"
+
+struct TerminalRig : TestRig
+{
+  RA8876Terminal term;
+
+  TerminalRig() : term(&tft)
+  {
+    tft.clearScreen(0);
+    tft.selectInternalFont(RA8876_FONT_SIZE_16);
+    ready = ready && term.begin();
+    term.setColors(RGB565(0, 255, 0), RGB565(0, 0, 64));
+    term.clear();
+  };
+};
+
+int main()
+{
+  {
+    TerminalRig a, b;
+    CHECK(a.ready && b.ready);
+
+    for (int i = 0; i < 1000; i++)
+    {
+      a.term.print("log entry number ");
+      a.term.println(i);
+    }
+    CHECK(a.emu.stats().blits > 0);  // Went round the ring
+
+    int rows = 600 / 16;
+    for (int i = 1000 - (rows - 1); i < 1000; i++)
+    {
+      b.term.print("log entry number ");
+      b.term.println(i);
+    }
+    CHECK_EQ(a.diffDisplay(b, 0, 0, 1024, 600), 0);
+    CHECK(a.clean());
+
+    // Back to the frame buffer, with the whole screen as the canvas
+    a.term.end();
+    uint16_t x, y, w, h;
+    a.tft.getCanvasWindow(&x, &y, &w, &h);
+    CHECK(x == 0 && y == 0 && w == 1024 && h == 600);
+  }
+
+  {
+    TerminalRig a, b;
+
+    // '\r' goes back to the start of the line, and new text replaces the old
+    a.term.print("abcdefgh\rXY");
+    b.term.print("XYcdefgh");
+    CHECK_EQ(a.diffDisplay(b, 0, 0, 1024, 600), 0);
+
+    // A long line wraps at the last column (128 with this font)
+    a.term.print("\n");
+    for (int i = 0; i < 130; i++)
+      a.term.write('a');
+    a.term.print("\r\n");
+    b.term.print("\n");
+    for (int i = 0; i < 128; i++)
+      b.term.write('a');
+    b.term.print("\naa\n");
+    CHECK_EQ(a.diffDisplay(b, 0, 0, 1024, 600), 0);
+
+    // An exactly full line followed by a newline leaves no blank line
+    for (int i = 0; i < 128; i++)
+      a.term.write('b');
+    a.term.println("z");
+    for (int i = 0; i < 128; i++)
+      b.term.write('b');
+    b.term.print("\nz\r\n");
+    CHECK_EQ(a.diffDisplay(b, 0, 0, 1024, 600), 0);
+
+    // The driver's text colour and cursor are as they were
+    a.tft.setTextColor(0xF800);
+    a.tft.setCursor(30, 40);
+    a.term.print("xyz");
+    CHECK_EQ(a.tft.getTextColor(), 0xF800);
+    CHECK_EQ(a.tft.getCursorX(), 30);
+    CHECK_EQ(a.tft.getCursorY(), 40);
+  }
+
+  return testExit("test_terminal");
+}
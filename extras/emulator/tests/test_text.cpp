@@ -0,0 +1,27 @@
+// Text engine output: a newline after an explicit setCursor() waits for the characters
+//  before it, and lands at the start of the next line.
+
+#include "RA8876Test.h"
+
+int main()
+{
+  TestRig rig, ref;
+  rig.tft.selectInternalFont(RA8876_FONT_SIZE_16);
+  ref.tft.selectInternalFont(RA8876_FONT_SIZE_16);
+
+  rig.tft.setCursor(20, 20);
+  rig.tft.print("ab\ncd");
+
+  ref.tft.setCursor(20, 20);
+  ref.tft.print("ab");
+  ref.tft.setCursor(0, 36);
+  ref.tft.print("cd");
+
+  CHECK(rig.clean());
+  CHECK_EQ(rig.emu.textLog().size(), 4);
+  CHECK_EQ(rig.tft.getCursorX(), ref.tft.getCursorX());
+  CHECK_EQ(rig.tft.getCursorY(), 36);
+  CHECK_EQ(rig.diffDisplay(ref, 0, 0, 1024, 100), 0);
+
+  return testExit("test_text");
+}
@@ -0,0 +1,89 @@
+// Text box: word wrapping, scrolling within the box, nothing drawn outside it, and the
+//  driver's state left alone.
+
+#include <RA8876TextBox.h>
+
+#include "RA8876Test.h"
+
+static int diffArea(RA8876Emulator &emu, int x1, int y1, int x2, int y2, int width, int height)
+{
+  int diff = 0;
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      if (emu.canvasPixel(x1 + x, y1 + y) != emu.canvasPixel(x2 + x, y2 + y))
+        diff++;
+
+  return diff;
+}
+
+int main()
+{
+  TestRig rig;
+  RA8876 &tft = rig.tft;
+  tft.clearScreen(0);
+  tft.selectInternalFont(RA8876_FONT_SIZE_16);
+
+  // Four lines of 16 pixels. Wrapping and scrolling leave the last four lines, which
+  //  must look the same as the lines written straight into another box.
+  RA8876TextBox box(&tft, 100, 40, 200, 64);
+  box.setColors(RGB565(0, 255, 0), RGB565(0, 0, 64));
+  box.clear();
+  box.print("hello ");
+  box.print("world, this is a long line that ");
+  box.print("wraps at words");
+  box.println();
+  for (int i = 0; i < 3; i++)
+  {
+    box.print("line ");
+    box.println(i);
+  }
+
+  RA8876TextBox ref(&tft, 400, 40, 200, 64);
+  ref.setColors(RGB565(0, 255, 0), RGB565(0, 0, 64));
+  ref.clear();
+  ref.print("line 0\nline 1\nline 2\n");
+  CHECK_EQ(diffArea(rig.emu, 100, 40, 400, 40, 200, 64), 0);
+
+  int outside = 0;
+  for (int y = 0; y < 600; y++)
+    for (int x = 0; x < 1024; x++)
+    {
+      bool inA = (x >= 100) && (x < 300) && (y >= 40) && (y < 104);
+      bool inB = (x >= 400) && (x < 600) && (y >= 40) && (y < 104);
+      if (!inA && !inB && (rig.emu.canvasPixel(x, y) != 0))
+        outside++;
+    }
+  CHECK_EQ(outside, 0);
+
+  // A word too long for a line is broken; the rest wraps as if written in one go
+  RA8876TextBox a(&tft, 100, 420, 200, 64), b(&tft, 400, 420, 200, 64);
+  a.clear();
+  b.clear();
+  a.print("012345678901234567890 abc");
+  a.print("def xyz");
+  b.print("012345678901234567890\nabcdef xyz");
+  CHECK_EQ(diffArea(rig.emu, 100, 420, 400, 420, 200, 64), 0);
+
+  // The canvas window, text colour and cursor are put back
+  tft.setTextColor(0xF800);
+  tft.setCursor(500, 500);
+  for (int i = 0; i < 20; i++)
+    box.println("scrolling");
+  uint16_t x, y, w, h;
+  tft.getCanvasWindow(&x, &y, &w, &h);
+  CHECK(x == 0 && y == 0 && w == 1024 && h == 600);
+  CHECK_EQ(tft.getTextColor(), 0xF800);
+  CHECK_EQ(tft.getCursorX(), 500);
+  CHECK_EQ(tft.getCursorY(), 500);
+  CHECK(rig.clean());
+
+  // scrollRect() moves the contents and clears what is uncovered
+  tft.fillRect(700, 300, 799, 399, RGB565(255, 0, 0));
+  tft.fillRect(700, 300, 799, 309, RGB565(0, 0, 255));
+  tft.scrollRect(700, 300, 100, 100, -20, 0);
+  CHECK_EQ(rig.emu.canvasPixel(750, 305), 0);
+  CHECK_EQ(rig.emu.canvasPixel(750, 325), RGB565(0, 0, 255));
+  CHECK_EQ(rig.emu.canvasPixel(750, 335), RGB565(255, 0, 0));
+
+  return testExit("test_textbox");
+}
@@ -0,0 +1,69 @@
+// UTF-8 decoding: the decoder on its own, with sequences split between calls and
+//  malformed input, and the driver showing malformed input as '?'.
+
+#include <vector>
+
+#include "RA8876Test.h"
+
+// Feeds bytes as the driver does, feeding a byte again when it cut a sequence short.
+static std::vector<int32_t> decode(RA8876Utf8Decoder &utf8, const char *s)
+{
+  std::vector<int32_t> out;
+  for (const char *p = s; *p; p++)
+  {
+    int32_t c = utf8.feed((uint8_t) *p);
+    if (c != RA8876_UTF8_PENDING)
+      out.push_back(c);
+    if (utf8.unread())
+      p--;
+  }
+
+  return out;
+}
+
+static bool same(const std::vector<int32_t> &got, std::initializer_list<int32_t> expect)
+{
+  return got == std::vector<int32_t>(expect);
+}
+
+int main()
+{
+  RA8876Utf8Decoder utf8;
+
+  CHECK(same(decode(utf8, "Az"), { 'A', 'z' }));
+  CHECK(same(decode(utf8, "\xC3\xA9"), { 0xE9 }));
+  CHECK(same(decode(utf8, "\xE4\xB8\xAD"), { 0x4E2D }));
+  CHECK(same(decode(utf8, "\xF0\x9F\x98\x80"), { 0x1F600 }));
+
+  // Split between calls
+  CHECK(same(decode(utf8, "\xE4\xB8"), { }));
+  CHECK(same(decode(utf8, "\xAD" "a"), { 0x4E2D, 'a' }));
+
+  // Malformed: a stray continuation byte, a sequence cut short by ASCII or by another
+  //  lead byte, an overlong encoding, and a surrogate
+  CHECK(same(decode(utf8, "\x80" "a"), { RA8876_UTF8_REPLACEMENT, 'a' }));
+  CHECK(same(decode(utf8, "\xE4\xB8" "b"), { RA8876_UTF8_REPLACEMENT, 'b' }));
+  CHECK(same(decode(utf8, "\xE4\xC3\xA9"), { RA8876_UTF8_REPLACEMENT, 0xE9 }));
+  CHECK(same(decode(utf8, "\xC0\xAF" "c"), { RA8876_UTF8_REPLACEMENT, 'c' }));
+  CHECK(same(decode(utf8, "\xED\xA0\x80"), { RA8876_UTF8_REPLACEMENT }));
+
+  // Driver: each malformed piece shows as one '?', including a sequence left
+  //  unfinished at the end of one print() and cut short by the next
+  TestRig rig(8);
+  rig.tft.selectExternalFont(RA8876_FONT_FAMILY_FIXED, RA8876_FONT_SIZE_16, RA8876_FONT_ENCODING_UNICODE, RA8876_FONT_FLAG_UTF8);
+  rig.emu.clearTextLog();
+  rig.tft.setCursor(0, 0);
+  rig.tft.print("\x80" "a\xE4\xB8" "b\xC0\xAF" "c\xE4");
+  rig.tft.print("d");
+
+  static const uint16_t expect[] = { '?', 'a', '?', 'b', '?', 'c', '?', 'd' };
+  CHECK_EQ(rig.emu.textLog().size(), 8);
+  for (size_t i = 0; (i < 8) && (i < rig.emu.textLog().size()); i++)
+    CHECK_EQ(rig.emu.textLog()[i], expect[i]);
+
+  CHECK_EQ(rig.tft.measureText("a\xE4\xB8" "b"), rig.tft.measureText("a?b"));
+  CHECK_EQ(rig.tft.measureText("c\xE4"), rig.tft.measureText("c?"));
+  CHECK_EQ(rig.tft.getCursorX(), rig.tft.measureText("?a?b?c?d"));
+
+  return testExit("test_utf8");
+}
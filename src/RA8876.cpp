@@ -1,5 +1,6 @@
 #pragma GCC diagnostic warning "-Wall"
 #include "RA8876.h"
+#include "RA8876Metrics.h"
 
 SdramInfo defaultSdramInfo =
 {
@@ -26,41 +27,33 @@ DisplayInfo defaultDisplayInfo =
   10      // VSYNC pulse width
 };
 
-void RA8876::writeCmd(uint8_t x)
+// Expands an RGB565 colour to 0xRRGGBB, repeating the top bits of each channel in the
+//  low bits so that full scale maps to 0xFF.
+static uint32_t rgb565To888(uint16_t color)
 {
-  digitalWrite(m_csPin, LOW);
-  SPI.transfer(RA8876_CMD_WRITE);
-  SPI.transfer(x);
-  digitalWrite(m_csPin, HIGH);
-}
+  uint8_t r = (color >> 11) << 3, g = ((color >> 5) & 0x3F) << 2, b = (color & 0x1F) << 3;
 
-void RA8876::writeData(uint8_t x)
-{
-  digitalWrite(m_csPin, LOW);
-  SPI.transfer(RA8876_DATA_WRITE);
-  SPI.transfer(x);
-  digitalWrite(m_csPin, HIGH);
+  return ((uint32_t) (r | (r >> 5)) << 16) | ((g | (g >> 6)) << 8) | (b | (b >> 5));
 }
 
-uint8_t RA8876::readData(void)
+static uint32_t rgb332To888(uint8_t color)
 {
-  digitalWrite(m_csPin, LOW);
-  SPI.transfer(RA8876_DATA_READ);
-  uint8_t x = SPI.transfer(0);
-  digitalWrite(m_csPin, HIGH);
-  return x;
+  uint8_t r = color & 0xE0, g = (color << 3) & 0xE0, b = (color << 6) & 0xC0;
+
+  return ((uint32_t) (r | (r >> 3) | (r >> 6)) << 16) | ((g | (g >> 3) | (g >> 6)) << 8) | (b | (b >> 2) | (b >> 4) | (b >> 6));
 }
 
-// Reads the special status register.
-// This register uses a special cycle type instead of having an address like other registers.
-// See data sheet section 19.1.
-uint8_t RA8876::readStatus(void)
+// Packs 0xRRGGBB into a pixel value at the given depth.
+static uint32_t packColor(uint32_t rgb, int depth)
 {
-  digitalWrite(m_csPin, LOW);
-  SPI.transfer(RA8876_STATUS_READ);
-  uint8_t x = SPI.transfer(0);
-  digitalWrite(m_csPin, HIGH);
-  return x;
+  uint8_t r = rgb >> 16, g = rgb >> 8, b = rgb;
+
+  if (depth == 8)
+    return RGB332(r, g, b);
+  else if (depth == 16)
+    return RGB565(r, g, b);
+  else
+    return rgb & 0xFFFFFF;
 }
 
 void RA8876::writeReg(uint8_t reg, uint8_t v)
@@ -110,14 +103,92 @@ uint16_t RA8876::readReg16(uint8_t reg)
   return v;
 }
 
+// Maps a geometry engine or foreground colour register to its slot in m_regCache.
+static inline int regCacheSlot(uint8_t reg)
+{
+  if ((reg >= RA8876_REG_FGCR) && (reg <= RA8876_REG_FGCB))
+    return (RA8876_REG_DEVR1 - RA8876_REG_DLHSR0 + 1) + (reg - RA8876_REG_FGCR);
+  else
+    return reg - RA8876_REG_DLHSR0;
+}
+
+// Writes a geometry engine or foreground colour register, unless the chip already
+//  holds that value from an earlier write. The engine never modifies these registers
+//  itself, so only the driver's own writes need tracking.
+void RA8876::writeCachedReg(uint8_t reg, uint8_t v)
+{
+  int slot = regCacheSlot(reg);
+  uint32_t bit = (uint32_t) 1 << slot;
+
+  if ((m_regCacheValid & bit) && (m_regCache[slot] == v))
+    return;
+
+  m_regCache[slot] = v;
+  m_regCacheValid |= bit;
+
+  writeReg(reg, v);
+}
+
+// Like writeCachedReg(), but for a 16-bit value in two successive registers, low byte first.
+void RA8876::writeCachedReg16(uint8_t reg, uint16_t v)
+{
+  writeCachedReg(reg, v & 0xFF);
+  writeCachedReg(reg + 1, v >> 8);
+}
+
+// Returns the shadow copy of a configuration register, saving a read from the chip.
+// With RA8876_VERIFY_SHADOW defined, the register is also read back, and any mismatch
+//  is reported and resolved in favour of the chip.
+uint8_t RA8876::readShadowReg(uint8_t reg, uint8_t *shadow)
+{
+  #if defined(RA8876_VERIFY_SHADOW)
+  uint8_t actual = readReg(reg);
+  if (actual != *shadow)
+  {
+    Serial.print("Shadow mismatch, reg 0x"); Serial.print(reg, HEX);
+    Serial.print(": shadow 0x"); Serial.print(*shadow, HEX);
+    Serial.print(", chip 0x"); Serial.println(actual, HEX);
+    *shadow = actual;
+  }
+  #else
+  (void) reg;
+  #endif // RA8876_VERIFY_SHADOW
+
+  return *shadow;
+}
+
+// Writes a configuration register and updates its shadow copy.
+void RA8876::writeShadowReg(uint8_t reg, uint8_t *shadow, uint8_t v)
+{
+  *shadow = v;
+  writeReg(reg, v);
+}
+
 RA8876::RA8876(int csPin, int resetPin)
+  : m_spiTransport(csPin)
+{
+  m_transport = &m_spiTransport;
+  m_resetPin  = resetPin;
+
+  initState();
+}
+
+// Uses the given transport (e.g. a parallel bus) instead of the built-in SPI one.
+RA8876::RA8876(RA8876Transport *transport, int resetPin)
+  : m_spiTransport(-1)
 {
-  m_csPin    = csPin;
-  m_resetPin = resetPin;
+  m_transport = transport;
+  m_resetPin  = resetPin;
+
+  initState();
+}
 
+void RA8876::initState(void)
+{
   m_width  = 0;
   m_height = 0;
   m_depth  = 0;
+  m_canvasDepth = 0;
 
   m_oscClock = 10000;  // 10000kHz or 10MHz
 
@@ -128,11 +199,44 @@ RA8876::RA8876(int csPin, int resetPin)
   m_textColor = 0xFFFF; // White
 
   m_fontRomInfo.present = false;  // No external font ROM chip
+
+  m_pageCount   = 0;
+  m_frontPage   = 0;
+  m_backPage    = 0;
+  m_pendingPage = -1;
+  m_flipPolled  = 0;
+
+  m_dirty = 0;
+
+  m_fifoFree = 0;
+
+  m_cursorKnown = false;
+  m_cursorStale = false;
+
+  m_unicodeMap     = 0;
+  m_unicodeMapSize = 0;
+
+  m_cgramAddress = RA8876_SDRAM_NONE;
+
+  m_glyphCache = 0;
+  m_glyphLead  = -1;
+
+  m_bitmapFont = 0;
+  m_kernLeft   = 0;
+
+  m_asyncDraw   = false;
+  m_taskPending = false;
+  m_pushActive  = false;
+
+  m_regCacheValid = 0;
 }
 
 // Trigger a hardware reset.
 void RA8876::hardReset(void)
 {
+  m_cursorKnown = false;
+  m_cursorStale = false;
+
   delay(5);
   digitalWrite(m_resetPin, LOW);
   delay(5);
@@ -146,10 +250,14 @@ void RA8876::hardReset(void)
 //  "internal state machine", not any configuration registers.
 void RA8876::softReset(void)
 {
-  SPI.beginTransaction(m_spiSettings);
+  m_cursorKnown = false;
+  m_cursorStale = false;
+
+  m_transport->beginTransaction();
 
   // Trigger soft reset
   writeReg(RA8876_REG_SRR, 0x01);
+  m_transport->flush();
   delay(5);
 
   // Wait for status register to show "normal operation".
@@ -162,7 +270,7 @@ void RA8876::softReset(void)
       break;
   }
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 
   return;
 }
@@ -305,7 +413,7 @@ bool RA8876::initPLL(void)
   Serial.println("init PLL");
   #endif // RA8876_DEBUG
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
   //Serial.print("DRAM_FREQ "); Serial.println(m_memPll.freq);
   //Serial.print("7: "); Serial.println(m_memPll.k << 1);
@@ -329,13 +437,15 @@ bool RA8876::initPLL(void)
 
   // Toggle bit 7 of the CCR register to trigger a reconfiguration of the PLLs
   writeReg(RA8876_REG_CCR, 0x00);
+  m_transport->flush();
   delay(2);
   writeReg(RA8876_REG_CCR, 0x80);
+  m_transport->flush();
   delay(2);
 
   uint8_t ccr = readReg(RA8876_REG_CCR);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 
   return (ccr & 0x80) ? true : false;
 }
@@ -380,7 +490,7 @@ bool RA8876::initMemory(SdramInfo *info)
   else
     sdrmd |= info->casLatency & 0x03;
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
   #if defined(RA8876_DEBUG)
   Serial.print("SDRAR: "); Serial.println(sdrar);  // Expected: 0x29 (41 decimal)
@@ -400,6 +510,7 @@ bool RA8876::initMemory(SdramInfo *info)
 
   // Trigger SDRAM initialization
   writeReg(RA8876_REG_SDRCR, 0x01);
+  m_transport->flush();
 
   // Wait for SDRAM to be ready
   uint8_t status;
@@ -411,7 +522,7 @@ bool RA8876::initMemory(SdramInfo *info)
       break;
   }
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 
   #if defined(RA8876_DEBUG)
   Serial.println(status);
@@ -422,23 +533,28 @@ bool RA8876::initMemory(SdramInfo *info)
 
 bool RA8876::initDisplay()
 {
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
+
+  m_regCacheValid = 0;  // Nothing is known about the engine registers yet
   
   // Set chip config register
   uint8_t ccr = readReg(RA8876_REG_CCR);
   ccr &= 0xE7;  // 24-bit LCD output
-  ccr &= 0xFE;  // 8-bit host data bus
-  writeReg(RA8876_REG_CCR, ccr);
+  if (m_transport->is16Bit())
+    ccr |= 0x01;  // 16-bit host data bus
+  else
+    ccr &= 0xFE;  // 8-bit host data bus
+  writeShadowReg(RA8876_REG_CCR, &m_ccr, ccr);
 
   writeReg(RA8876_REG_MACR, 0x00);  // Direct write, left-to-right-top-to-bottom memory
 
-  writeReg(RA8876_REG_ICR, 0x00);  // Graphics mode, memory is SDRAM
+  writeShadowReg(RA8876_REG_ICR, &m_icr, 0x00);  // Graphics mode, memory is SDRAM
 
   uint8_t dpcr = readReg(RA8876_REG_DPCR);
   dpcr &= 0xFB;  // Vertical scan top to bottom
   dpcr &= 0xF8;  // Colour order RGB
   dpcr |= 0x80;  // Panel fetches PDAT at PCLK falling edge
-  writeReg(RA8876_REG_DPCR, dpcr);
+  writeShadowReg(RA8876_REG_DPCR, &m_dpcr, dpcr);
 
   uint8_t pcsr = readReg(RA8876_REG_PCSR);
   pcsr |= 0x80;  // XHSYNC polarity high
@@ -474,8 +590,9 @@ bool RA8876::initDisplay()
   // Set VSYNC pulse width
   writeReg(RA8876_REG_VPWR, m_displayInfo->vPulseWidth - 1);
 
-  // Set main window to 16 bits per pixel
-  writeReg(RA8876_REG_MPWCTR, 0x04);  // PIP windows disabled, 16-bpp, enable sync signals
+  // Set main window colour depth
+  writeShadowReg(RA8876_REG_MPWCTR, &m_mpwctr, depthBits(m_depth) << 2);  // PIP windows disabled, enable sync signals
+  writeShadowReg(RA8876_REG_PIPCDEP, &m_pipcdep, 0x05);  // Both PIP windows 16-bpp
 
   // Set main window start address to 0
   writeReg(RA8876_REG_MISA0, 0);
@@ -503,6 +620,9 @@ bool RA8876::initDisplay()
   writeReg(RA8876_REG_CVS_IMWTH0, m_width & 0xFF);
   writeReg(RA8876_REG_CVS_IMWTH1, m_width >> 8);
 
+  m_canvasAddress = 0;
+  m_canvasWidth   = m_width;
+
   // Set active window start coordinates
   writeReg(RA8876_REG_AWUL_X0, 0);
   writeReg(RA8876_REG_AWUL_X1, 0);
@@ -515,35 +635,38 @@ bool RA8876::initDisplay()
   writeReg(RA8876_REG_AW_HT0, m_height & 0xFF);
   writeReg(RA8876_REG_AW_HT1, m_height >> 8);
 
+  m_windowX      = 0;
+  m_windowY      = 0;
+  m_windowWidth  = m_width;
+  m_windowHeight = m_height;
+
   // Set canvas addressing mode/colour depth
-  uint8_t aw_color = 0x00;  // 2d addressing mode
-  if (m_depth == 16)
-    aw_color |= 0x01;
-  else if (m_depth == 24)
-    aw_color |= 0x02;
-  writeReg(RA8876_REG_AW_COLOR, aw_color);
+  m_canvasDepth = m_depth;
+  writeShadowReg(RA8876_REG_AW_COLOR, &m_awColor, depthBits(m_depth));  // 2d addressing mode
+
+  // Take a copy of the text engine settings, which are only ever modified from here on
+  m_ccr1 = readReg(RA8876_REG_CCR1);
   
   // Turn on display
-  dpcr = readReg(RA8876_REG_DPCR);
-  dpcr |= 0x40;  // Display on
-  writeReg(RA8876_REG_DPCR, dpcr);
+  writeShadowReg(RA8876_REG_DPCR, &m_dpcr, m_dpcr | 0x40);  // Display on
 
   // TODO: Track backlight pin and turn on backlight
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 
   return true;
 }
 
-bool RA8876::init(void)
+// Depth is the colour depth of the display and the initial canvas: 8, 16 or 24 bits per
+//  pixel.
+bool RA8876::init(int depth)
 {
+  if ((depth != 8) && (depth != 16) && (depth != 24))
+    return false;
+
   m_width  = m_displayInfo->width;
   m_height = m_displayInfo->height;
-  m_depth  = 16;
-
-  // Set up chip select pin
-  pinMode(m_csPin, OUTPUT);
-  digitalWrite(m_csPin, HIGH);
+  m_depth  = depth;
 
   // Set up reset pin, if provided
   if (m_resetPin >= 0)
@@ -560,11 +683,9 @@ bool RA8876::init(void)
     return false;
   }
 
-  SPI.begin();
+  m_transport->begin();
 
-  m_spiSettings = SPISettings(RA8876_SPI_SPEED, MSBFIRST, SPI_MODE3);
-
-  // SPI is now up, so we can do a soft reset if no hard reset was possible earlier
+  // Host bus is now up, so we can do a soft reset if no hard reset was possible earlier
   if (m_resetPin < 0)
     softReset();
 
@@ -586,6 +707,12 @@ bool RA8876::init(void)
     return false;
   }
 
+  // Everything but the visible framebuffer is free for offscreen use
+  m_sdram.begin(getSdramSize());
+  m_sdram.alloc(frameSize());
+  m_cgramAddress = RA8876_SDRAM_NONE;
+  m_glyphCache   = 0;
+
   // Set default font
   selectInternalFont(RA8876_FONT_SIZE_16);
   setTextScale(1);
@@ -593,6 +720,43 @@ bool RA8876::init(void)
   return true;
 }
 
+// Returns the size of the SDRAM in bytes, from its geometry. The data bus is 16 bits.
+uint32_t RA8876::getSdramSize(void)
+{
+  return ((uint32_t) m_sdramInfo->banks << m_sdramInfo->rowBits << m_sdramInfo->colBits) * 2;
+}
+
+// Allocates an offscreen image in SDRAM at the given colour depth (0 for the canvas
+//  depth). The width is rounded up to a multiple of 4, as block addressing requires.
+bool RA8876::allocSurface(uint16_t width, uint16_t height, SdramSurface *surface, int depth)
+{
+  if (!depth)
+    depth = m_canvasDepth;
+  else if ((depth != 8) && (depth != 16) && (depth != 24))
+    return false;
+
+  width = (width + 3) & ~0x3;
+
+  uint32_t stride  = (uint32_t) width * (depth / 8);
+  uint32_t address = m_sdram.alloc(stride * height);
+  if (address == RA8876_SDRAM_NONE)
+    return false;
+
+  surface->address = address;
+  surface->width   = width;
+  surface->height  = height;
+  surface->stride  = stride;
+  surface->depth   = depth;
+
+  return true;
+}
+
+void RA8876::freeSurface(SdramSurface *surface)
+{
+  m_sdram.free(surface->address);
+  surface->address = RA8876_SDRAM_NONE;
+}
+
 void RA8876::initExternalFontRom(int spiIf, enum ExternalFontRom chip)
 {
   // See data sheet figure 16-10
@@ -616,12 +780,12 @@ void RA8876::initExternalFontRom(int spiIf, enum ExternalFontRom chip)
   Serial.print("External font SPI divisor: "); Serial.println(divisor);
   #endif // RA8876_DEBUG
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
   // Ensure SPI is enabled in chip config register
-  uint8_t ccr = readReg(RA8876_REG_CCR);
+  uint8_t ccr = readShadowReg(RA8876_REG_CCR, &m_ccr);
   if (!(ccr & 0x02))
-    writeReg(RA8876_REG_CCR, ccr | 0x02);
+    writeShadowReg(RA8876_REG_CCR, &m_ccr, ccr | 0x02);
 
   #if defined(RA8876_DEBUG)
   Serial.print("SFL_CTRL: "); Serial.println(((spiIf & 1) << 7) | 0x14, HEX);
@@ -636,13 +800,13 @@ void RA8876::initExternalFontRom(int spiIf, enum ExternalFontRom chip)
   #endif // RA8876_DEBUG
   writeReg(RA8876_REG_GTFNT_SEL, (chip & 0x07) << 5);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 }
 
 // Relatively expensive and causes brief flicker when enabled.
 //void RA8876::enableDisplay(bool enable)
 //{
-//  SPI.beginTransaction(m_spiSettings);
+//  m_transport->beginTransaction();
 //  
 //  uint8_t dpcr = readReg(RA8876_REG_DPCR);
 //
@@ -653,7 +817,7 @@ void RA8876::initExternalFontRom(int spiIf, enum ExternalFontRom chip)
 //
 //  writeReg(RA8876_REG_DPCR, dpcr);
 //
-//  SPI.endTransaction();
+//  m_transport->endTransaction();
 //}
 
 bool RA8876::setCanvasRegion(uint32_t address, uint16_t width)
@@ -663,12 +827,17 @@ bool RA8876::setCanvasRegion(uint32_t address, uint16_t width)
   else if ((width & 0x03) || (width > 0x1FFF))
     return false;  // Width must be multiple of 4 and fit in 13 bits
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
+
+  waitPendingTask();
 
   // Set canvas start address
   writeReg32(RA8876_REG_CVSSA0, address);
+
+  m_canvasAddress = address;
+  m_canvasWidth   = width;
   
-  uint8_t aw_color = readReg(RA8876_REG_AW_COLOR);
+  uint8_t aw_color = readShadowReg(RA8876_REG_AW_COLOR, &m_awColor);
 
   if (width)
   {
@@ -680,9 +849,30 @@ bool RA8876::setCanvasRegion(uint32_t address, uint16_t width)
     aw_color |= 0x04;  // Linear mode
   }
 
-  writeReg(RA8876_REG_AW_COLOR, aw_color);
+  writeShadowReg(RA8876_REG_AW_COLOR, &m_awColor, aw_color);
+
+  m_transport->endTransaction();
+
+  return true;
+}
+
+// Sets the colour depth of the canvas: 8, 16 or 24 bits per pixel. Pixel data and
+//  colours are converted to suit as they are drawn.
+bool RA8876::setCanvasDepth(int depth)
+{
+  if ((depth != 8) && (depth != 16) && (depth != 24))
+    return false;
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
 
-  SPI.endTransaction();
+  uint8_t aw_color = readShadowReg(RA8876_REG_AW_COLOR, &m_awColor);
+  writeShadowReg(RA8876_REG_AW_COLOR, &m_awColor, (aw_color & 0xFC) | depthBits(depth));
+
+  m_canvasDepth = depth;
+
+  m_transport->endTransaction();
 
   return true;
 }
@@ -694,8 +884,24 @@ bool RA8876::setCanvasWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t he
   else if (y + height > 8191)
     return false;
 
-  SPI.beginTransaction(m_spiSettings);
-    
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  m_windowX      = x;
+  m_windowY      = y;
+  m_windowWidth  = width;
+  m_windowHeight = height;
+
+  writeActiveWindow(x, y, width, height);
+
+  m_transport->endTransaction();
+
+  return true;
+}
+
+void RA8876::writeActiveWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
   // Set active window offset
   writeReg16(RA8876_REG_AWUL_X0, x);
   writeReg16(RA8876_REG_AWUL_Y0, y);
@@ -703,10 +909,70 @@ bool RA8876::setCanvasWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t he
   // Set active window dimensions
   writeReg16(RA8876_REG_AW_WTH0, width);
   writeReg16(RA8876_REG_AW_HT0, height);
+}
 
-  SPI.endTransaction();
+// Reports an area of the canvas as drawn on, clipped to the canvas window, to the
+//  dirty tracker if there is one.
+void RA8876::markDirty(int x1, int y1, int x2, int y2)
+{
+  if (!m_dirty)
+    return;
 
-  return true;
+  if (x1 > x2)
+  {
+    int t = x1; x1 = x2; x2 = t;
+  }
+  if (y1 > y2)
+  {
+    int t = y1; y1 = y2; y2 = t;
+  }
+
+  // Clip to canvas window
+  if (x1 < m_windowX)
+    x1 = m_windowX;
+  if (y1 < m_windowY)
+    y1 = m_windowY;
+  if (x2 >= m_windowX + m_windowWidth)
+    x2 = m_windowX + m_windowWidth - 1;
+  if (y2 >= m_windowY + m_windowHeight)
+    y2 = m_windowY + m_windowHeight - 1;
+
+  if ((x1 <= x2) && (y1 <= y2))
+    m_dirty->add(x1, y1, x2, y2);
+}
+
+// Copies each dirty rectangle from one full-screen image to another with the BTE, e.g.
+//  from a back buffer to the displayed one, then clears the tracker.
+void RA8876::copyDirty(uint32_t srcAddr, uint32_t dstAddr, uint16_t width)
+{
+  if (!m_dirty)
+    return;
+
+  // The copies themselves should not count as drawing
+  RA8876DirtyTracker *tracker = m_dirty;
+  m_dirty = 0;
+
+  for (int i = 0; i < tracker->count(); i++)
+  {
+    const DirtyRect *r = tracker->rect(i);
+    bteCopy(srcAddr, width, r->x1, r->y1, dstAddr, width, r->x1, r->y1, r->x2 - r->x1 + 1, r->y2 - r->y1 + 1);
+  }
+
+  tracker->clear();
+  m_dirty = tracker;
+}
+
+// Marks the text drawn since the cursor was at the given position. Text that ran onto
+//  further lines is taken to cover the full width of the canvas window.
+void RA8876::markTextDirty(int x, int y)
+{
+  int endX = getCursorX();
+  int endY = getCursorY();
+
+  if (endY == y)
+    markDirty(x, y, endX - 1, y + getTextSizeY() - 1);
+  else
+    markDirty(m_windowX, y, m_windowX + m_windowWidth - 1, endY + getTextSizeY() - 1);
 }
 
 bool RA8876::setDisplayRegion(uint32_t address, uint16_t width)
@@ -716,7 +982,7 @@ bool RA8876::setDisplayRegion(uint32_t address, uint16_t width)
   else if ((width & 0x03) || (width > 8188))
     return false;  // Width must be multiple of 4 and max 8188
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
   
   // Set main window start address
   writeReg32(RA8876_REG_MISA0, address);
@@ -724,7 +990,35 @@ bool RA8876::setDisplayRegion(uint32_t address, uint16_t width)
   // Set main window image width
   writeReg16(RA8876_REG_MIW0, width);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
+
+  return true;
+}
+
+// Sets the colour depth of the main window: 8, 16 or 24 bits per pixel. The SDRAM
+//  reserved for the framebuffer at address 0 is resized to suit, which fails if it
+//  would need to grow into memory already allocated. Pages set up by initPages() were
+//  sized for the old depth, so they must be set up again after a change, and the depth
+//  can't grow while they exist.
+bool RA8876::setDisplayDepth(int depth)
+{
+  if ((depth != 8) && (depth != 16) && (depth != 24))
+    return false;
+
+  uint32_t size = (uint32_t) m_width * m_height * (depth / 8);
+  if ((m_pageCount > 0) && (size > frameSize()))
+    return false;
+  else if (!m_sdram.resize(0, size))
+    return false;
+
+  m_transport->beginTransaction();
+
+  uint8_t mpwctr = readShadowReg(RA8876_REG_MPWCTR, &m_mpwctr);
+  writeShadowReg(RA8876_REG_MPWCTR, &m_mpwctr, (mpwctr & 0xF3) | (depthBits(depth) << 2));
+
+  m_depth = depth;
+
+  m_transport->endTransaction();
 
   return true;
 }
@@ -736,13 +1030,13 @@ bool RA8876::setDisplayOffset(uint16_t x, uint16_t y)
   else if (y > 8191)
     return false;
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
   // Set main window offset
   writeReg16(RA8876_REG_MWULX0, x & 0xFFFC);  // Low two bits must be zero
   writeReg16(RA8876_REG_MWULY0, y);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 
   return true;
 }
@@ -752,391 +1046,2495 @@ bool RA8876::setDisplayOffset(uint16_t x, uint16_t y)
 //  the pattern rather than the contents of memory.
 void RA8876::colorBarTest(bool enabled)
 {
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
-  uint8_t dpcr = readReg(RA8876_REG_DPCR);
+  uint8_t dpcr = readShadowReg(RA8876_REG_DPCR, &m_dpcr);
 
   if (enabled)
     dpcr = dpcr | 0x20;
   else
     dpcr = dpcr & ~0x20;
 
-  writeReg(RA8876_REG_DPCR, dpcr);
+  writeShadowReg(RA8876_REG_DPCR, &m_dpcr, dpcr);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
 }
 
-void RA8876::drawPixel(int x, int y, uint16_t color)
+// If a shape was left drawing in asynchronous mode, waits for it to finish.
+// Must be called before touching any geometry engine registers.
+void RA8876::waitPendingTask(void)
 {
-  //Serial.println("drawPixel");
-  //Serial.println(readStatus());
-  
-  SPI.beginTransaction(m_spiSettings);
-
-  writeReg(RA8876_REG_CURH0, x & 0xFF);
-  writeReg(RA8876_REG_CURH1, x >> 8);
-
-  writeReg(RA8876_REG_CURV0, y & 0xFF);
-  writeReg(RA8876_REG_CURV1, y >> 8);
+  if (!m_taskPending)
+    return;
 
-  writeReg(RA8876_REG_MRWDP, color & 0xFF);
-  writeReg(RA8876_REG_MRWDP, color >> 8);
-  
-  SPI.endTransaction();
+  waitTaskBusy();
+  m_taskPending = false;
 }
 
-void RA8876::drawTwoPointShape(int x1, int y1, int x2, int y2, uint16_t color, uint8_t reg, uint8_t cmd)
+// Selects which PIP window's registers are accessed, for pip 1 or 2.
+bool RA8876::selectPip(int pip)
 {
-  //Serial.println("drawTwoPointShape");
+  if ((pip != 1) && (pip != 2))
+    return false;
 
-  SPI.beginTransaction(m_spiSettings);
+  uint8_t mpwctr = readShadowReg(RA8876_REG_MPWCTR, &m_mpwctr);
+  if (pip == 1)
+    mpwctr &= 0xEF;
+  else
+    mpwctr |= 0x10;
 
-  // First point
-  writeReg(RA8876_REG_DLHSR0, x1 & 0xFF);
-  writeReg(RA8876_REG_DLHSR1, x1 >> 8);
-  writeReg(RA8876_REG_DLVSR0, y1 & 0xFF);
-  writeReg(RA8876_REG_DLVSR1, y1 >> 8);
+  if (mpwctr != m_mpwctr)
+    writeShadowReg(RA8876_REG_MPWCTR, &m_mpwctr, mpwctr);
 
-  // Second point
-  writeReg(RA8876_REG_DLHER0, x2 & 0xFF);
-  writeReg(RA8876_REG_DLHER1, x2 >> 8);
-  writeReg(RA8876_REG_DLVER0, y2 & 0xFF);
-  writeReg(RA8876_REG_DLVER1, y2 >> 8);
+  return true;
+}
 
-  // Colour
-  writeReg(RA8876_REG_FGCR, color >> 11 << 3);
-  writeReg(RA8876_REG_FGCG, ((color >> 5) & 0x3F) << 2);
-  writeReg(RA8876_REG_FGCB, (color & 0x1F) << 3);
+// Sets up PIP window 1 or 2 to show part of an image held in SDRAM: the rectangle of
+//  the given size at (imageX, imageY) within the image. Depth is 8, 16 or 24 bits per
+//  pixel. The window is composited over the main window by the display hardware, so
+//  it can be moved and shown without touching the canvas. PIP 1 is drawn above PIP 2.
+// The address must be a multiple of 4, and the image width, window width and window
+//  X position multiples of 4.
+bool RA8876::setPipWindow(int pip, uint32_t address, uint16_t imageWidth, int depth, uint16_t imageX, uint16_t imageY, uint16_t width, uint16_t height)
+{
+  if (address & 0x3)
+    return false;
+  else if ((imageWidth & 0x3) || (imageWidth > 8188) || (width & 0x3))
+    return false;
+  else if ((depth != 8) && (depth != 16) && (depth != 24))
+    return false;
 
-  // Draw
-  writeReg(reg, cmd);  // Start drawing
+  m_transport->beginTransaction();
 
-  // Wait for completion
-  uint8_t status = readStatus();
-  int iter = 0;
-  while (status & 0x08)
+  if (!selectPip(pip))
   {
-    status = readStatus();
-    iter++;
+    m_transport->endTransaction();
+    return false;
   }
 
-  //Serial.print(iter); Serial.println(" iterations");
+  uint8_t bits = depthBits(depth);
+  uint8_t pipcdep = readShadowReg(RA8876_REG_PIPCDEP, &m_pipcdep);
+  if (pip == 1)
+    pipcdep = (pipcdep & 0xF3) | (bits << 2);
+  else
+    pipcdep = (pipcdep & 0xFC) | bits;
+  writeShadowReg(RA8876_REG_PIPCDEP, &m_pipcdep, pipcdep);
+
+  writeReg32(RA8876_REG_PISA0, address);
+  writeReg16(RA8876_REG_PIW0, imageWidth);
+  writeReg16(RA8876_REG_PWIULX0, imageX);
+  writeReg16(RA8876_REG_PWIULY0, imageY);
+  writeReg16(RA8876_REG_PWW0, width);
+  writeReg16(RA8876_REG_PWH0, height);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
+
+  return true;
 }
 
-void RA8876::drawThreePointShape(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color, uint8_t reg, uint8_t cmd)
+// Moves a PIP window to (x, y) on the display. X must be a multiple of 4.
+bool RA8876::movePip(int pip, uint16_t x, uint16_t y)
 {
-  //Serial.println("drawThreePointShape");
-
-  SPI.beginTransaction(m_spiSettings);
+  if (x & 0x3)
+    return false;
 
-  // First point
-  writeReg(RA8876_REG_DLHSR0, x1 & 0xFF);
-  writeReg(RA8876_REG_DLHSR1, x1 >> 8);
-  writeReg(RA8876_REG_DLVSR0, y1 & 0xFF);
-  writeReg(RA8876_REG_DLVSR1, y1 >> 8);
+  m_transport->beginTransaction();
 
-  // Second point
-  writeReg(RA8876_REG_DLHER0, x2 & 0xFF);
-  writeReg(RA8876_REG_DLHER1, x2 >> 8);
-  writeReg(RA8876_REG_DLVER0, y2 & 0xFF);
-  writeReg(RA8876_REG_DLVER1, y2 >> 8);
+  bool ok = selectPip(pip);
+  if (ok)
+  {
+    writeReg16(RA8876_REG_PWDULX0, x);
+    writeReg16(RA8876_REG_PWDULY0, y);
+  }
 
-  // Third point
-  writeReg(RA8876_REG_DTPH0, x3 & 0xFF);
-  writeReg(RA8876_REG_DTPH1, x3 >> 8);
-  writeReg(RA8876_REG_DTPV0, y3 & 0xFF);
-  writeReg(RA8876_REG_DTPV1, y3 >> 8);
+  m_transport->endTransaction();
 
-  // Colour
-  writeReg(RA8876_REG_FGCR, color >> 11 << 3);
-  writeReg(RA8876_REG_FGCG, ((color >> 5) & 0x3F) << 2);
-  writeReg(RA8876_REG_FGCB, (color & 0x1F) << 3);
+  return ok;
+}
 
-  // Draw
-  writeReg(reg, cmd);  // Start drawing
+// Changes which part of its image a PIP window shows.
+bool RA8876::scrollPip(int pip, uint16_t imageX, uint16_t imageY)
+{
+  m_transport->beginTransaction();
 
-  // Wait for completion
-  uint8_t status = readStatus();
-  int iter = 0;
-  while (status & 0x08)
+  bool ok = selectPip(pip);
+  if (ok)
   {
-    status = readStatus();
-    iter++;
+    writeReg16(RA8876_REG_PWIULX0, imageX);
+    writeReg16(RA8876_REG_PWIULY0, imageY);
   }
 
-  //Serial.print(iter); Serial.println(" iterations");
+  m_transport->endTransaction();
 
-  SPI.endTransaction();
+  return ok;
 }
 
-void RA8876::drawEllipseShape(int x, int y, int xrad, int yrad, uint16_t color, uint8_t cmd)
+void RA8876::enablePip(int pip, bool enabled)
 {
-  //Serial.println("drawEllipseShape");
+  uint8_t bit;
+  if (pip == 1)
+    bit = 0x80;
+  else if (pip == 2)
+    bit = 0x40;
+  else
+    return;
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
-  // First point
-  writeReg16(RA8876_REG_DEHR0, x);
-  writeReg16(RA8876_REG_DEVR0, y);
+  uint8_t mpwctr = readShadowReg(RA8876_REG_MPWCTR, &m_mpwctr);
+  if (enabled)
+    mpwctr |= bit;
+  else
+    mpwctr &= ~bit;
+  writeShadowReg(RA8876_REG_MPWCTR, &m_mpwctr, mpwctr);
 
-  // Radii
-  writeReg16(RA8876_REG_ELL_A0, xrad);
-  writeReg16(RA8876_REG_ELL_B0, yrad);
+  m_transport->endTransaction();
+}
 
-  // Colour
-  writeReg(RA8876_REG_FGCR, color >> 11 << 3);
-  writeReg(RA8876_REG_FGCG, ((color >> 5) & 0x3F) << 2);
-  writeReg(RA8876_REG_FGCB, (color & 0x1F) << 3);
+// Sets up count full-screen pages for flicker-free animation: the framebuffer at
+//  address 0 and the rest allocated from SDRAM. Page 0 is displayed and drawing is
+//  directed to page 1; requestFlip() or flip() then shows the finished page and moves
+//  drawing on to the next one.
+bool RA8876::initPages(int count)
+{
+  if ((count < 2) || (count > RA8876_MAX_PAGES))
+    return false;
 
-  // Draw
-  writeReg(RA8876_REG_DCR1, cmd);  // Start drawing
+  // Page 0 is the framebuffer set up by init(). Release any other pages from before.
+  for (int i = 1; i < m_pageCount; i++)
+    m_sdram.free(m_pageAddress[i]);
+  m_pageCount = 0;
 
-  // Wait for completion
-  uint8_t status = readStatus();
-  int iter = 0;
-  while (status & 0x08)
+  m_pageAddress[0] = 0;
+  for (int i = 1; i < count; i++)
   {
-    status = readStatus();
-    iter++;
+    m_pageAddress[i] = m_sdram.alloc(frameSize());
+    if (m_pageAddress[i] == RA8876_SDRAM_NONE)
+    {
+      while (--i > 0)
+        m_sdram.free(m_pageAddress[i]);
+      return false;
+    }
   }
 
-  //Serial.print(iter); Serial.println(" iterations");
+  m_pageCount   = count;
+  m_frontPage   = 0;
+  m_backPage    = 1;
+  m_pendingPage = -1;
 
-  SPI.endTransaction();
-}
+  setDisplayRegion(getPageAddress(m_frontPage), m_width);
+  setCanvasRegion(getPageAddress(m_backPage), m_width);
+  setCanvasWindow(0, 0, m_width, m_height);
 
-void RA8876::setCursor(int x, int y)
-{
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
-  writeReg16(RA8876_REG_F_CURX0, x);
-  writeReg16(RA8876_REG_F_CURY0, y);
+  // Enable the VSYNC flag, and clear any stale event
+  writeReg(RA8876_REG_INTEN, readReg(RA8876_REG_INTEN) | 0x10);
+  writeReg(RA8876_REG_INTF, 0x10);
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
+
+  return true;
 }
 
-int RA8876::getCursorX(void)
+// Points the canvas at a page, keeping the canvas window.
+void RA8876::setCanvasPage(int page)
 {
-  SPI.beginTransaction(m_spiSettings);
+  waitPendingTask();
 
-  int x = readReg16(RA8876_REG_F_CURX0);
+  m_canvasAddress = getPageAddress(page);
+  writeReg32(RA8876_REG_CVSSA0, m_canvasAddress);
+}
 
-  SPI.endTransaction();
+// Time from the start of VSYNC to the end of vertical blanking, in microseconds.
+uint32_t RA8876::blankingMicros(void)
+{
+  uint32_t lineClocks = m_displayInfo->width + m_displayInfo->hFrontPorch +
+                        m_displayInfo->hBackPorch + m_displayInfo->hPulseWidth;
+  uint32_t lines = m_displayInfo->vPulseWidth + m_displayInfo->vBackPorch;
 
-  return x;
+  return (lines * lineClocks * 1000) / m_displayInfo->dotClock;
 }
 
-int RA8876::getCursorY(void)
+// Queues the page just drawn to be shown at the next vertical blanking, and returns
+//  without waiting. The flip happens in updateFlip(), which must be polled until it
+//  returns true.
+// With three or more pages, drawing moves on to the next page at once. With two, the
+//  canvas stays on the page queued for display, since the only other page is still on
+//  screen: anything drawn before updateFlip() returns true would land on the page
+//  about to be shown, so the caller must not draw until then.
+bool RA8876::requestFlip(void)
 {
-  SPI.beginTransaction(m_spiSettings);
+  if (m_pageCount < 2)
+    return false;
 
-  int y = readReg16(RA8876_REG_F_CURY0);
+  // Only one flip can be queued
+  while (!updateFlip(true));
 
-  SPI.endTransaction();
+  m_transport->beginTransaction();
 
-  return y;
+  // The page must be finished before it is shown
+  waitPendingTask();
+
+  m_flipPolled = micros();
+  writeReg(RA8876_REG_INTF, 0x10);  // Clear VSYNC flag
+
+  m_pendingPage = m_backPage;
+  m_backPage    = (m_backPage + 1) % m_pageCount;
+
+  if (m_backPage != m_frontPage)
+    setCanvasPage(m_backPage);
+
+  m_transport->endTransaction();
+
+  return true;
 }
 
-// Given a font encoding value, returns the corresponding bit pattern for
-//  use by internal fonts.
-uint8_t RA8876::internalFontEncoding(enum FontEncoding enc)
+// Completes a flip queued by requestFlip() if VSYNC has occurred since. Returns true
+//  if the flip has been done (or none was pending).
+// The VSYNC flag says that blanking has begun, but not how long ago. The new address
+//  is only written if the flag was still clear at the previous poll less than a
+//  blanking interval earlier, so that the write is known to land within blanking.
+//  Otherwise the flag is cleared and this returns false, to try again at the next
+//  VSYNC; or with wait set, it waits for that VSYNC, which can take up to a frame.
+// Polling more often than every blankingMicros() (about 0.9ms with the default
+//  display timing) flips at the first VSYNC. A caller that polls less often may miss
+//  blanking every time, and should pass wait once it has nothing else to do.
+bool RA8876::updateFlip(bool wait)
 {
-  uint8_t e;
-  switch (enc)
+  if (m_pendingPage < 0)
+    return true;
+
+  m_transport->beginTransaction();
+
+  bool vsync = readReg(RA8876_REG_INTF) & 0x10;
+  unsigned long now = micros();
+
+  if (vsync && (now - m_flipPolled >= blankingMicros()))
   {
-  case RA8876_FONT_ENCODING_8859_2:
-    e = 0x01;
-    break;
-  case RA8876_FONT_ENCODING_8859_4:
-    e = 0x02;
-    break;
-  case RA8876_FONT_ENCODING_8859_5:
-    e = 0x03;
-    break;
-  default:
-    e = 0x00;  // ISO-8859-1
-    break;
+    // Too late to be sure of blanking: watch for the next VSYNC
+    writeReg(RA8876_REG_INTF, 0x10);
+    vsync = false;
   }
 
-  return e;
+  if (!vsync)
+  {
+    m_flipPolled = now;
+
+    // The flag is known to be clear, so the next VSYNC starts a fresh blanking interval
+    if (wait)
+    {
+      while (!(readReg(RA8876_REG_INTF) & 0x10));
+      vsync = true;
+    }
+  }
+
+  if (vsync)
+  {
+    writeReg32(RA8876_REG_MISA0, getPageAddress(m_pendingPage));
+
+    m_frontPage   = m_pendingPage;
+    m_pendingPage = -1;
+
+    // With two pages, the page that has just left the screen is free to draw on
+    if (m_pageCount == 2)
+      setCanvasPage(m_backPage);
+  }
+
+  m_transport->endTransaction();
+
+  return vsync;
 }
 
-void RA8876::setTextMode(void)
+// Shows the page just drawn at the next vertical blanking, waiting for it.
+void RA8876::flip(void)
 {
-  // Restore text colour
-  writeReg(RA8876_REG_FGCR, m_textColor >> 11 << 3);
-  writeReg(RA8876_REG_FGCG, ((m_textColor >> 5) & 0x3F) << 2);
-  writeReg(RA8876_REG_FGCB, (m_textColor & 0x1F) << 3);
-
-  waitTaskBusy();
+  if (!requestFlip())
+    return;
 
-  // Enable text mode
-  uint8_t icr = readReg(RA8876_REG_ICR);
-  writeReg(RA8876_REG_ICR, icr | 0x04);
+  while (!updateFlip(true));
 }
 
-void RA8876::setGraphicsMode(void)
+// Selects whether shape drawing returns as soon as the shape has been started (true) or
+//  waits for the chip to finish it (false, the default). In asynchronous mode the wait
+//  is deferred until the geometry engine is next used, so the caller can do other work
+//  while the chip draws.
+void RA8876::setAsyncDrawing(bool enabled)
 {
-  waitTaskBusy();
+  if (!enabled)
+    waitIdle();
 
-  // Disable text mode
-  uint8_t icr = readReg(RA8876_REG_ICR);
-  writeReg(RA8876_REG_ICR, icr & ~0x04);
+  m_asyncDraw = enabled;
 }
 
-void RA8876::selectInternalFont(enum FontSize size, enum FontEncoding enc)
+// Returns true if a shape started in asynchronous mode is still being drawn.
+bool RA8876::isBusy(void)
 {
-  m_fontSource = RA8876_FONT_SOURCE_INTERNAL;
-  m_fontSize   = size;
-  m_fontFlags  = 0;
+  if (!m_taskPending)
+    return false;
 
-  SPI.beginTransaction(m_spiSettings);
+  m_transport->beginTransaction();
 
-  writeReg(RA8876_REG_CCR0, 0x00 | ((size & 0x03) << 4) | internalFontEncoding(enc));
+  if (!(readStatus() & 0x08))
+    m_taskPending = false;
 
-  uint8_t ccr1 = readReg(RA8876_REG_CCR1);
+  m_transport->endTransaction();
+
+  return m_taskPending;
+}
+
+// Waits for any shape started in asynchronous mode to finish.
+void RA8876::waitIdle(void)
+{
+  if (!m_taskPending)
+    return;
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  m_transport->endTransaction();
+}
+
+void RA8876::drawPixel(int x, int y, uint16_t color)
+{
+  //Serial.println("drawPixel");
+  //Serial.println(readStatus());
+  
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  markDirty(x, y, x, y);
+
+  writeReg(RA8876_REG_CURH0, x & 0xFF);
+  writeReg(RA8876_REG_CURH1, x >> 8);
+
+  writeReg(RA8876_REG_CURV0, y & 0xFF);
+  writeReg(RA8876_REG_CURV1, y >> 8);
+
+  writeCmd(RA8876_REG_MRWDP);
+  if (m_canvasDepth == 16)
+  {
+    m_transport->writeData16(color);
+  }
+  else
+  {
+    uint32_t value = packColor(rgb565To888(color), m_canvasDepth);
+    for (int i = 0; i < m_canvasDepth / 8; i++)
+      writeData(value >> (i * 8));
+  }
+
+  m_transport->endTransaction();
+}
+
+// Sets the foreground colour used by the geometry and text engines.
+// The colour registers are 8 bits per channel at every depth; the engines use the top
+//  bits to suit the canvas.
+void RA8876::setForegroundColor(uint16_t color)
+{
+  setForegroundRgb(rgb565To888(color));
+}
+
+void RA8876::setForegroundRgb(uint32_t rgb)
+{
+  writeCachedReg(RA8876_REG_FGCR, rgb >> 16);
+  writeCachedReg(RA8876_REG_FGCG, (rgb >> 8) & 0xFF);
+  writeCachedReg(RA8876_REG_FGCB, rgb & 0xFF);
+}
+
+// Reads pixel i of a source buffer in RGB332 (1 byte), RGB565 (2) or RGB888 (3,
+//  red first), and returns it as 0xRRGGBB.
+static uint32_t readSourcePixel(const uint8_t *pixels, int srcBytes, unsigned int i, bool progmem)
+{
+  if (srcBytes == 2)
+  {
+    const uint16_t *p = (const uint16_t *) pixels + i;
+    return rgb565To888(progmem ? pgm_read_word(p) : *p);
+  }
+
+  const uint8_t *p = pixels + (i * srcBytes);
+  if (srcBytes == 1)
+    return rgb332To888(progmem ? pgm_read_byte(p) : *p);
+  else if (progmem)
+    return ((uint32_t) pgm_read_byte(p) << 16) | (pgm_read_byte(p + 1) << 8) | pgm_read_byte(p + 2);
+  else
+    return ((uint32_t) p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+// Streams pixels to the memory port, which must already be selected, converting them
+//  from the source format to the canvas depth. Waits for the write FIFO to drain before
+//  each FIFO-sized chunk so that no data is dropped.
+void RA8876::writeMemory(const uint8_t *pixels, int srcBytes, unsigned int count, bool progmem)
+{
+  int bytes = m_canvasDepth / 8;
+  bool wide = (bytes == 2) && m_transport->is16Bit();
+  unsigned int chunk = wide ? RA8876_WRITE_FIFO_DEPTH : (RA8876_WRITE_FIFO_DEPTH / bytes);
+  uint8_t buffer[RA8876_WRITE_FIFO_DEPTH];
+
+  while (count)
+  {
+    unsigned int n = (count < chunk) ? count : chunk;
+
+    waitWriteFifoEmpty();
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+      uint32_t color;
+      if ((srcBytes == 2) && (bytes == 2))
+        color = progmem ? pgm_read_word((const uint16_t *) pixels + i) : ((const uint16_t *) pixels)[i];
+      else
+        color = packColor(readSourcePixel(pixels, srcBytes, i, progmem), m_canvasDepth);
+
+      if (wide)
+      {
+        m_transport->writeData16(color);
+      }
+      else
+      {
+        // Low byte first
+        for (int k = 0; k < bytes; k++)
+          buffer[(i * bytes) + k] = color >> (k * 8);
+      }
+    }
+
+    if (!wide)
+      m_transport->writeDataBlock(buffer, n * bytes);
+
+    pixels += n * srcBytes;
+    count  -= n;
+  }
+}
+
+// Copies a rectangle of pixels into the canvas at (x, y), clipped to the canvas
+//  window, converting from the source format (1, 2 or 3 bytes per pixel for RGB332,
+//  RGB565 or RGB888) to the canvas depth. The active window is temporarily narrowed
+//  to the rectangle, so that the memory cursor wraps to the next row on its own and
+//  each row streams without any register writes. Stride is the distance between
+//  source rows in pixels (0 means the same as the width), for copying part of a
+//  larger image.
+void RA8876::pushPixels(int x, int y, int width, int height, const uint8_t *pixels, int srcBytes, int stride, bool progmem)
+{
+  if (stride <= 0)
+    stride = width;
+
+  // Clip to canvas window
+  if (x < m_windowX)
+  {
+    pixels += (m_windowX - x) * srcBytes;
+    width  -= m_windowX - x;
+    x = m_windowX;
+  }
+  if (y < m_windowY)
+  {
+    pixels += (uint32_t) (m_windowY - y) * stride * srcBytes;
+    height -= m_windowY - y;
+    y = m_windowY;
+  }
+  if (x + width > m_windowX + m_windowWidth)
+    width = m_windowX + m_windowWidth - x;
+  if (y + height > m_windowY + m_windowHeight)
+    height = m_windowY + m_windowHeight - y;
+
+  if ((width <= 0) || (height <= 0))
+    return;
+
+  markDirty(x, y, x + width - 1, y + height - 1);
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  writeActiveWindow(x, y, width, height);
+
+  writeReg16(RA8876_REG_CURH0, x);
+  writeReg16(RA8876_REG_CURV0, y);
+
+  writeCmd(RA8876_REG_MRWDP);
+
+  if (stride == width)
+  {
+    writeMemory(pixels, srcBytes, width * height, progmem);
+  }
+  else
+  {
+    for (int row = 0; row < height; row++)
+      writeMemory(pixels + ((uint32_t) row * stride * srcBytes), srcBytes, width, progmem);
+  }
+
+  // Restore the canvas window
+  waitWriteFifoEmpty();
+  writeActiveWindow(m_windowX, m_windowY, m_windowWidth, m_windowHeight);
+
+  m_transport->endTransaction();
+}
+
+// Prepares to stream RGB565 pixels into a rectangle of a 16bpp canvas with
+//  pushAsync(). The rectangle must lie within the canvas window. The bus stays claimed until
+//  endPushAsync(), and no other drawing may be done in between.
+bool RA8876::beginPushAsync(int x, int y, int width, int height)
+{
+  if (m_canvasDepth != 16)
+    return false;  // Data goes straight from the buffer, so it must be RGB565 already
+
+  if ((width <= 0) || (height <= 0) || (x < m_windowX) || (y < m_windowY) ||
+      (x + width > m_windowX + m_windowWidth) || (y + height > m_windowY + m_windowHeight))
+    return false;
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  writeActiveWindow(x, y, width, height);
+
+  writeReg16(RA8876_REG_CURH0, x);
+  writeReg16(RA8876_REG_CURV0, y);
+
+  writeCmd(RA8876_REG_MRWDP);
+
+  markDirty(x, y, x + width - 1, y + height - 1);
+
+  m_pushActive = true;
+
+  return true;
+}
+
+// Starts sending the next count pixels of the rectangle, row by row, and returns as
+//  soon as the transport allows (at once, for a DMA-capable transport). Waits for the
+//  previous piece first, so two buffers can be alternated: fill one while the other
+//  is sent. The buffer must be left alone until isPushBusy() returns false or the
+//  callback is called.
+// Nothing stops a transfer from filling the write FIFO faster than the chip empties
+//  it, so for a transport that can outrun it, all but the last FIFO-sized piece are
+//  sent here with a wait for an empty FIFO before each, and only the last goes in the
+//  background.
+void RA8876::pushAsync(const uint16_t *pixels, unsigned int count, RA8876TransferCallback callback, void *context)
+{
+  if (!m_pushActive)
+    return;
+
+  while (m_transport->transferBusy());
+
+  if (m_transport->outrunsFifo())
+  {
+    unsigned int chunk = m_transport->is16Bit() ? RA8876_WRITE_FIFO_DEPTH : (RA8876_WRITE_FIFO_DEPTH / 2);
+
+    while (count > chunk)
+    {
+      waitWriteFifoEmpty();
+      m_transport->writeData16Async(pixels, chunk, 0, 0);
+      while (m_transport->transferBusy());
+
+      pixels += chunk;
+      count  -= chunk;
+    }
+
+    waitWriteFifoEmpty();
+  }
+
+  m_transport->writeData16Async(pixels, count, callback, context);
+}
+
+// Returns true while a piece started by pushAsync() is still being sent.
+bool RA8876::isPushBusy(void)
+{
+  return m_pushActive && m_transport->transferBusy();
+}
+
+// Waits for the last piece to be sent, restores the canvas window and releases the bus.
+void RA8876::endPushAsync(void)
+{
+  if (!m_pushActive)
+    return;
+
+  while (m_transport->transferBusy());
+
+  waitWriteFifoEmpty();
+  writeActiveWindow(m_windowX, m_windowY, m_windowWidth, m_windowHeight);
+
+  m_pushActive = false;
+
+  m_transport->endTransaction();
+}
+
+void RA8876::drawTwoPointShape(int x1, int y1, int x2, int y2, uint16_t color, uint8_t reg, uint8_t cmd)
+{
+  //Serial.println("drawTwoPointShape");
+
+  markDirty(x1, y1, x2, y2);
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  // First point
+  writeCachedReg16(RA8876_REG_DLHSR0, x1);
+  writeCachedReg16(RA8876_REG_DLVSR0, y1);
+
+  // Second point
+  writeCachedReg16(RA8876_REG_DLHER0, x2);
+  writeCachedReg16(RA8876_REG_DLVER0, y2);
+
+  // Colour
+  setForegroundColor(color);
+
+  // Draw
+  writeReg(reg, cmd);  // Start drawing
+
+  // Wait for completion, or leave that until the engine is next needed
+  if (m_asyncDraw)
+    m_taskPending = true;
+  else
+    waitTaskBusy();
+
+  m_transport->endTransaction();
+}
+
+void RA8876::drawThreePointShape(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color, uint8_t reg, uint8_t cmd)
+{
+  //Serial.println("drawThreePointShape");
+
+  markDirty(min(x1, min(x2, x3)), min(y1, min(y2, y3)), max(x1, max(x2, x3)), max(y1, max(y2, y3)));
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  // First point
+  writeCachedReg16(RA8876_REG_DLHSR0, x1);
+  writeCachedReg16(RA8876_REG_DLVSR0, y1);
+
+  // Second point
+  writeCachedReg16(RA8876_REG_DLHER0, x2);
+  writeCachedReg16(RA8876_REG_DLVER0, y2);
+
+  // Third point
+  writeCachedReg16(RA8876_REG_DTPH0, x3);
+  writeCachedReg16(RA8876_REG_DTPV0, y3);
+
+  // Colour
+  setForegroundColor(color);
+
+  // Draw
+  writeReg(reg, cmd);  // Start drawing
+
+  // Wait for completion, or leave that until the engine is next needed
+  if (m_asyncDraw)
+    m_taskPending = true;
+  else
+    waitTaskBusy();
+
+  m_transport->endTransaction();
+}
+
+void RA8876::drawEllipseShape(int x, int y, int xrad, int yrad, uint16_t color, uint8_t cmd)
+{
+  //Serial.println("drawEllipseShape");
+
+  markDirty(x - xrad, y - yrad, x + xrad, y + yrad);
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  // First point
+  writeCachedReg16(RA8876_REG_DEHR0, x);
+  writeCachedReg16(RA8876_REG_DEVR0, y);
+
+  // Radii
+  writeCachedReg16(RA8876_REG_ELL_A0, xrad);
+  writeCachedReg16(RA8876_REG_ELL_B0, yrad);
+
+  // Colour
+  setForegroundColor(color);
+
+  // Draw
+  writeReg(RA8876_REG_DCR1, cmd);  // Start drawing
+
+  // Wait for completion, or leave that until the engine is next needed
+  if (m_asyncDraw)
+    m_taskPending = true;
+  else
+    waitTaskBusy();
+
+  m_transport->endTransaction();
+}
+
+// Returns the BTE_COLR value for both sources and the destination at the canvas depth.
+//  Copies between images of different depths are not supported.
+uint8_t RA8876::bteColorDepth(void)
+{
+  uint8_t depth = depthBits(m_canvasDepth);
+
+  return (depth << 5) | (depth << 2) | depth;
+}
+
+// Runs one BTE operation from source 0 to the destination. Source 1 is set to the
+//  destination, so raster operations combine the source with what is already there.
+void RA8876::bteStart(uint8_t ctrl1, uint32_t s0Addr, uint16_t s0Width, int s0x, int s0y,
+                      uint32_t dtAddr, uint16_t dtWidth, int dtx, int dty, int width, int height)
+{
+  waitPendingTask();
+
+  writeReg32(RA8876_REG_S0_STR0, s0Addr);
+  writeReg16(RA8876_REG_S0_WTH0, s0Width);
+  writeReg16(RA8876_REG_S0_X0, s0x);
+  writeReg16(RA8876_REG_S0_Y0, s0y);
+
+  writeReg32(RA8876_REG_S1_STR0, dtAddr);
+  writeReg16(RA8876_REG_S1_WTH0, dtWidth);
+  writeReg16(RA8876_REG_S1_X0, dtx);
+  writeReg16(RA8876_REG_S1_Y0, dty);
+
+  writeReg32(RA8876_REG_DT_STR0, dtAddr);
+  writeReg16(RA8876_REG_DT_WTH0, dtWidth);
+  writeReg16(RA8876_REG_DT_X0, dtx);
+  writeReg16(RA8876_REG_DT_Y0, dty);
+
+  writeReg16(RA8876_REG_BTE_WTH0, width);
+  writeReg16(RA8876_REG_BTE_HIG0, height);
+
+  writeReg(RA8876_REG_BTE_COLR, bteColorDepth());
+  writeReg(RA8876_REG_BTE_CTRL1, ctrl1);
+  writeReg(RA8876_REG_BTE_CTRL0, 0x10);  // Start
+
+  // Wait for completion, or leave that until the engine is next needed
+  if (m_asyncDraw)
+    m_taskPending = true;
+  else
+    waitTaskBusy();
+}
+
+// Copies a rectangle between two block-mode images in SDRAM. The engine always works
+//  top to bottom and left to right, so when the rectangles overlap within the same
+//  image and the destination is below (or directly right of) the source, the copy is
+//  split into bands no deeper than the offset, done last band first.
+bool RA8876::bteCopyRect(uint8_t ctrl1, uint32_t srcAddr, uint16_t srcWidth, int sx, int sy,
+                         uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height)
+{
+  if ((srcAddr & 0x3) || (dstAddr & 0x3))
+    return false;  // Addresses must be multiples of 4
+  else if ((srcWidth & 0x3) || (srcWidth > 0x1FFF) || (dstWidth & 0x3) || (dstWidth > 0x1FFF))
+    return false;  // Widths must be multiples of 4 and fit in 13 bits
+  else if ((sx < 0) || (sy < 0) || (dx < 0) || (dy < 0) || (width <= 0) || (height <= 0))
+    return false;
+
+  if ((dstAddr == m_canvasAddress) && (dstWidth == m_canvasWidth))
+    markDirty(dx, dy, dx + width - 1, dy + height - 1);
+
+  bool overlap = (srcAddr == dstAddr) && (srcWidth == dstWidth) &&
+                 (sx < dx + width) && (dx < sx + width) && (sy < dy + height) && (dy < sy + height);
+
+  m_transport->beginTransaction();
+
+  if (overlap && (dy > sy))
+  {
+    int band = dy - sy;
+    for (int bottom = height; bottom > 0; bottom -= band)
+    {
+      int h = (bottom < band) ? bottom : band;
+      bteStart(ctrl1, srcAddr, srcWidth, sx, sy + bottom - h, dstAddr, dstWidth, dx, dy + bottom - h, width, h);
+    }
+  }
+  else if (overlap && (dy == sy) && (dx > sx))
+  {
+    int band = dx - sx;
+    for (int right = width; right > 0; right -= band)
+    {
+      int w = (right < band) ? right : band;
+      bteStart(ctrl1, srcAddr, srcWidth, sx + right - w, sy, dstAddr, dstWidth, dx + right - w, dy, w, height);
+    }
+  }
+  else
+  {
+    bteStart(ctrl1, srcAddr, srcWidth, sx, sy, dstAddr, dstWidth, dx, dy, width, height);
+  }
+
+  m_transport->endTransaction();
+
+  return true;
+}
+
+// Sets the BTE chroma key colour, which shares the background colour registers.
+void RA8876::setKeyColor(uint16_t color)
+{
+  uint32_t rgb = rgb565To888(color);
+
+  writeReg(RA8876_REG_BGCR, rgb >> 16);
+  writeReg(RA8876_REG_BGCG, (rgb >> 8) & 0xFF);
+  writeReg(RA8876_REG_BGCB, rgb & 0xFF);
+}
+
+// Copies a rectangle from one image in SDRAM to another (or within one image),
+//  combining it with the destination using the given raster operation. Images are in
+//  block mode at the canvas colour depth, as set up with setCanvasRegion().
+bool RA8876::bteCopy(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height, enum BteRop rop)
+{
+  return bteCopyRect((rop << 4) | RA8876_BTE_MEMORY_COPY_ROP, srcAddr, srcWidth, sx, sy, dstAddr, dstWidth, dx, dy, width, height);
+}
+
+// As bteCopy(), but source pixels of the key colour are skipped, leaving the
+//  destination showing through.
+bool RA8876::bteCopyTransparent(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height, uint16_t keyColor)
+{
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+  setKeyColor(keyColor);
+
+  m_transport->endTransaction();
+
+  return bteCopyRect(RA8876_BTE_MEMORY_COPY_CHROMA, srcAddr, srcWidth, sx, sy, dstAddr, dstWidth, dx, dy, width, height);
+}
+
+// Draws a sprite or icon held elsewhere in SDRAM onto the canvas at (x, y), clipped to
+//  the canvas window, with pixels of the key colour left transparent. The canvas must
+//  be in block mode.
+bool RA8876::drawSprite(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, int x, int y, int width, int height, uint16_t keyColor)
+{
+  if (!m_canvasWidth)
+    return false;  // Linear canvas
+
+  // Clip to canvas window
+  if (x < m_windowX)
+  {
+    sx    += m_windowX - x;
+    width -= m_windowX - x;
+    x = m_windowX;
+  }
+  if (y < m_windowY)
+  {
+    sy     += m_windowY - y;
+    height -= m_windowY - y;
+    y = m_windowY;
+  }
+  if (x + width > m_windowX + m_windowWidth)
+    width = m_windowX + m_windowWidth - x;
+  if (y + height > m_windowY + m_windowHeight)
+    height = m_windowY + m_windowHeight - y;
+
+  if ((width <= 0) || (height <= 0))
+    return true;  // Nothing visible
+
+  return bteCopyTransparent(srcAddr, srcWidth, sx, sy, m_canvasAddress, m_canvasWidth, x, y, width, height, keyColor);
+}
+
+// Scrolls a rectangle of the canvas up by dy pixels (down if negative) with a BTE copy
+//  within the canvas, and fills the strip that is uncovered. The canvas must be in
+//  block mode.
+bool RA8876::scrollRect(int x, int y, int width, int height, int dy, uint16_t fill)
+{
+  if (!m_canvasWidth)
+    return false;  // Linear canvas
+  else if ((width <= 0) || (height <= 0))
+    return true;
+
+  int shift = abs(dy);
+  if (shift >= height)
+  {
+    fillRect(x, y, x + width - 1, y + height - 1, fill);
+    return true;
+  }
+  else if (shift == 0)
+  {
+    return true;
+  }
+
+  if (dy > 0)
+  {
+    bteCopy(m_canvasAddress, m_canvasWidth, x, y + shift, m_canvasAddress, m_canvasWidth, x, y, width, height - shift);
+    fillRect(x, y + height - shift, x + width - 1, y + height - 1, fill);
+  }
+  else
+  {
+    bteCopy(m_canvasAddress, m_canvasWidth, x, y, m_canvasAddress, m_canvasWidth, x, y + shift, width, height - shift);
+    fillRect(x, y, x + width - 1, y + shift - 1, fill);
+  }
+
+  return true;
+}
+
+// Sets up the BTE to colour expand from a one-bit-per-pixel image, packed into pixels of
+//  the canvas depth, onto the canvas.
+void RA8876::beginExpand(const SdramSurface *source)
+{
+  waitPendingTask();
+
+  writeReg32(RA8876_REG_S0_STR0, source->address);
+  writeReg16(RA8876_REG_S0_WTH0, source->width);
+  writeReg32(RA8876_REG_DT_STR0, m_canvasAddress);
+  writeReg16(RA8876_REG_DT_WTH0, m_canvasWidth);
+  writeReg(RA8876_REG_BTE_COLR, bteColorDepth());
+}
+
+// Colour expands a width x height bitmap whose top left pixel starts the source pixel
+//  at (sx, sy) onto the canvas at (x, y), clipped to the canvas window, in the
+//  foreground colour. Clear bits leave the canvas alone. The images are those given to
+//  beginExpand(), and only the position and size registers are written here. The
+//  canvas must be 8 or 16 bits deep.
+void RA8876::bteExpand(int sx, int sy, int x, int y, int width, int height)
+{
+  int bits = m_canvasDepth;
+  if ((bits != 8) && (bits != 16))
+    return;  // The start bit must fit in the four bits BTE_CTRL1 has for it
+
+  int x1 = max(x, (int) m_windowX);
+  int y1 = max(y, (int) m_windowY);
+  int x2 = min(x + width, m_windowX + m_windowWidth);
+  int y2 = min(y + height, m_windowY + m_windowHeight);
+  if ((x1 >= x2) || (y1 >= y2))
+    return;
+
+  // Columns clipped off the left are skipped by starting part way into a pixel
+  int skip = x1 - x;
+  int startBit = bits - 1 - (skip % bits);
+  sx += skip / bits;
+  sy += y1 - y;
+
+  markDirty(x1, y1, x2 - 1, y2 - 1);
+
+  waitPendingTask();
+
+  writeReg16(RA8876_REG_S0_X0, sx);
+  writeReg16(RA8876_REG_S0_Y0, sy);
+  writeReg16(RA8876_REG_DT_X0, x1);
+  writeReg16(RA8876_REG_DT_Y0, y1);
+  writeReg16(RA8876_REG_BTE_WTH0, x2 - x1);
+  writeReg16(RA8876_REG_BTE_HIG0, y2 - y1);
+
+  writeReg(RA8876_REG_BTE_CTRL1, (startBit << 4) | RA8876_BTE_MEMORY_COPY_EXPAND_CHROMA);
+  writeReg(RA8876_REG_BTE_CTRL0, 0x10);  // Start
+
+  if (m_asyncDraw)
+    m_taskPending = true;
+  else
+    waitTaskBusy();
+}
+
+void RA8876::setCursor(int x, int y)
+{
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  writeReg16(RA8876_REG_F_CURX0, x);
+  writeReg16(RA8876_REG_F_CURY0, y);
+
+  m_transport->endTransaction();
+
+  m_cursorX = x;
+  m_cursorY = y;
+  m_cursorKnown = true;
+  m_cursorStale = false;
+  m_kernLeft    = 0;
+}
+
+// Reads back the text cursor position, if the software copy can't be trusted.
+void RA8876::syncCursor(void)
+{
+  if (m_cursorKnown)
+    return;
+
+  m_transport->beginTransaction();
+
+  m_cursorX = readReg16(RA8876_REG_F_CURX0);
+  m_cursorY = readReg16(RA8876_REG_F_CURY0);
+
+  m_transport->endTransaction();
+
+  m_cursorKnown = true;
+}
+
+// Moves the software copy of the text cursor past one character, wrapping at the
+//  canvas window edge as the text engine does. Only the internal font and half-width
+//  user fonts have a known glyph width; text in other fonts leaves the position to be
+//  read back.
+void RA8876::advanceCursor(void)
+{
+  bool fixed = (m_fontSource == RA8876_FONT_SOURCE_INTERNAL) ||
+               ((m_fontSource == RA8876_FONT_SOURCE_USER) && !m_cgramFullWidth);
+  if (!fixed)
+  {
+    m_cursorKnown = false;
+    return;
+  }
+
+  int width = ((m_fontSize + 2) * 4) * m_textScaleX;  // Half of the cell height
+
+  if (m_cursorX + width > m_windowX + m_windowWidth)
+  {
+    m_cursorX = m_windowX;
+    m_cursorY += getTextSizeY();
+  }
+
+  m_cursorX += width;
+}
+
+int RA8876::getCursorX(void)
+{
+  syncCursor();
+
+  return m_cursorX;
+}
+
+int RA8876::getCursorY(void)
+{
+  syncCursor();
+
+  return m_cursorY;
+}
+
+// Given a font encoding value, returns the corresponding bit pattern for
+//  use by internal fonts.
+uint8_t RA8876::internalFontEncoding(enum FontEncoding enc)
+{
+  uint8_t e;
+  switch (enc)
+  {
+  case RA8876_FONT_ENCODING_8859_2:
+    e = 0x01;
+    break;
+  case RA8876_FONT_ENCODING_8859_4:
+    e = 0x02;
+    break;
+  case RA8876_FONT_ENCODING_8859_5:
+    e = 0x03;
+    break;
+  default:
+    e = 0x00;  // ISO-8859-1
+    break;
+  }
+
+  return e;
+}
+
+void RA8876::setTextMode(void)
+{
+  waitPendingTask();
+
+  // Catch the chip up with text drawn from the glyph cache
+  if (m_cursorStale)
+  {
+    writeReg16(RA8876_REG_F_CURX0, m_cursorX);
+    writeReg16(RA8876_REG_F_CURY0, m_cursorY);
+    m_cursorStale = false;
+  }
+
+  // Restore text colour
+  setForegroundColor(m_textColor);
+
+  waitTaskBusy();
+
+  // Enable text mode
+  uint8_t icr = readShadowReg(RA8876_REG_ICR, &m_icr);
+  writeShadowReg(RA8876_REG_ICR, &m_icr, icr | 0x04);
+}
+
+void RA8876::setGraphicsMode(void)
+{
+  waitTaskBusy();
+
+  // Disable text mode
+  uint8_t icr = readShadowReg(RA8876_REG_ICR, &m_icr);
+  writeShadowReg(RA8876_REG_ICR, &m_icr, icr & ~0x04);
+}
+
+void RA8876::selectInternalFont(enum FontSize size, enum FontEncoding enc)
+{
+  m_fontSource   = RA8876_FONT_SOURCE_INTERNAL;
+  m_fontSize     = size;
+  m_fontFlags    = 0;
+  m_fontFamily   = RA8876_FONT_FAMILY_FIXED;
+  m_fontEncoding = enc;
+
+  m_transport->beginTransaction();
+
+  writeReg(RA8876_REG_CCR0, 0x00 | ((size & 0x03) << 4) | internalFontEncoding(enc));
+
+  uint8_t ccr1 = readShadowReg(RA8876_REG_CCR1, &m_ccr1);
+  ccr1 |= 0x40;  // Transparent background
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1);
+
+  m_transport->endTransaction();
+}
+
+void RA8876::selectExternalFont(enum ExternalFontFamily family, enum FontSize size, enum FontEncoding enc, FontFlags flags)
+{
+  m_fontSource   = RA8876_FONT_SOURCE_EXT_ROM;
+  m_fontSize     = size;
+  m_fontFlags    = flags;
+  m_fontFamily   = family;
+  m_fontEncoding = enc;
+
+  m_utf8.reset();
+  m_glyphLead = -1;
+
+  m_transport->beginTransaction();
+
+  #if defined(RA8876_DEBUG)
+  Serial.print("CCR0: "); Serial.println(0x40 | ((size & 0x03) << 4), HEX);
+  #endif // RA8876_DEBUG
+  writeReg(RA8876_REG_CCR0, 0x40 | ((size & 0x03) << 4));  // Select external font ROM and size
+
+  uint8_t ccr1 = readShadowReg(RA8876_REG_CCR1, &m_ccr1);
+  ccr1 |= 0x40;  // Transparent background
+  #if defined(RA8876_DEBUG)
+  Serial.print("CCR1: "); Serial.println(ccr1, HEX);
+  #endif // RA8876_DEBUG
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1);
+
+  #if defined(RA8876_DEBUG)
+  Serial.print("GTFNT_CR: "); Serial.println((enc << 3) | (family & 0x03), HEX);
+  #endif // RA8876_DEBUG
+  writeReg(RA8876_REG_GTFNT_CR, (enc << 3) | (family & 0x03));  // Character encoding and family
+
+  m_transport->endTransaction();
+}
+
+// Bytes of bitmap per glyph in a user-defined font: one bit per pixel, rows padded to
+//  whole bytes, most significant bit leftmost.
+static uint32_t userGlyphBytes(enum FontSize size, bool fullWidth)
+{
+  int height = (size + 2) * 8;
+  int width  = fullWidth ? height : (height / 2);
+
+  return (uint32_t) ((width + 7) / 8) * height;
+}
+
+// Sets aside SDRAM for a user-defined font (CGRAM) of count glyphs, replacing any
+//  earlier one. Half-width fonts have codes 0x00 up, and full-width fonts codes 0x8000
+//  up, which text output sends as two bytes.
+bool RA8876::initUserFont(enum FontSize size, unsigned int count, bool fullWidth)
+{
+  if ((count == 0) || (!fullWidth && (count > 0x100)) || (count > 0x8000))
+    return false;
+
+  if (m_cgramAddress != RA8876_SDRAM_NONE)
+    m_sdram.free(m_cgramAddress);
+
+  m_cgramAddress = m_sdram.alloc(userGlyphBytes(size, fullWidth) * count);
+  if (m_cgramAddress == RA8876_SDRAM_NONE)
+    return false;
+
+  m_cgramSize      = size;
+  m_cgramCount     = count;
+  m_cgramFullWidth = fullWidth;
+
+  m_transport->beginTransaction();
+  writeReg32(RA8876_REG_CGRAM_STR0, m_cgramAddress);
+  m_transport->endTransaction();
+
+  return true;
+}
+
+// Stores glyph bitmaps for count codes starting at the given one, in one stream. The
+//  canvas is switched to linear 8bpp addressing for the duration, so the bytes land
+//  one after another from the glyph's address.
+bool RA8876::loadUserChars(uint16_t code, unsigned int count, const uint8_t *bitmaps, bool progmem)
+{
+  if (m_cgramAddress == RA8876_SDRAM_NONE)
+    return false;
+
+  unsigned int index = m_cgramFullWidth ? (code - 0x8000) : code;
+  if ((m_cgramFullWidth && (code < 0x8000)) || (index + count > m_cgramCount))
+    return false;
+
+  uint32_t glyphBytes = userGlyphBytes(m_cgramSize, m_cgramFullWidth);
+  uint32_t size = glyphBytes * count;
+  uint8_t buffer[RA8876_WRITE_FIFO_DEPTH];
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  uint8_t awColor = readShadowReg(RA8876_REG_AW_COLOR, &m_awColor);
+  writeShadowReg(RA8876_REG_AW_COLOR, &m_awColor, 0x04);  // Linear addressing, 8bpp
+
+  writeReg32(RA8876_REG_CURH0, m_cgramAddress + (index * glyphBytes));
+
+  writeCmd(RA8876_REG_MRWDP);
+  for (uint32_t i = 0; i < size; i += RA8876_WRITE_FIFO_DEPTH)
+  {
+    uint32_t n = min(size - i, (uint32_t) RA8876_WRITE_FIFO_DEPTH);
+
+    for (uint32_t k = 0; k < n; k++)
+      buffer[k] = progmem ? pgm_read_byte(bitmaps + i + k) : bitmaps[i + k];
+
+    waitWriteFifoEmpty();
+    m_transport->writeDataBlock(buffer, n);
+  }
+
+  waitWriteFifoEmpty();
+
+  writeShadowReg(RA8876_REG_AW_COLOR, &m_awColor, awColor);
+
+  m_transport->endTransaction();
+
+  return true;
+}
+
+// Selects the font set up with initUserFont() for text output.
+void RA8876::selectUserFont(void)
+{
+  m_fontSource   = RA8876_FONT_SOURCE_USER;
+  m_fontSize     = m_cgramSize;
+  m_fontFlags    = 0;
+  m_fontFamily   = RA8876_FONT_FAMILY_FIXED;
+  m_fontEncoding = RA8876_FONT_ENCODING_8859_1;
+
+  m_transport->beginTransaction();
+
+  writeReg(RA8876_REG_CCR0, 0x80 | ((m_cgramSize & 0x03) << 4));  // User-defined font, size
+
+  uint8_t ccr1 = readShadowReg(RA8876_REG_CCR1, &m_ccr1);
   ccr1 |= 0x40;  // Transparent background
-  writeReg(RA8876_REG_CCR1, ccr1);
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1);
+
+  m_transport->endTransaction();
+}
+
+int RA8876::getTextSizeY(void)
+{
+  if (m_fontSource == RA8876_FONT_SOURCE_BITMAP)
+    return m_bitmapFont->font()->yAdvance;
+
+  return ((m_fontSize + 2) * 8) * m_textScaleY;
+}
+
+// Width of a half-width character in the current font, at a text scale of 1. The
+//  proportional ROM families have their own widths for ASCII.
+int RA8876::halfWidth(uint8_t c)
+{
+  if ((c >= RA8876_METRICS_FIRST) && (c <= RA8876_METRICS_LAST) && (m_fontSource == RA8876_FONT_SOURCE_EXT_ROM))
+  {
+    if (m_fontFamily == RA8876_FONT_FAMILY_ARIAL)
+      return pgm_read_byte(&ra8876ArialWidths[m_fontSize][c - RA8876_METRICS_FIRST]);
+    else if (m_fontFamily == RA8876_FONT_FAMILY_TIMES)
+      return pgm_read_byte(&ra8876TimesWidths[m_fontSize][c - RA8876_METRICS_FIRST]);
+  }
+
+  return (m_fontSize + 2) * 4;
+}
+
+// Decodes the UTF-8 sequence that starts with c, taking any further bytes from str[*pos]
+//  on. A sequence that is cut short, by another character or the end of the string,
+//  gives RA8876_UTF8_REPLACEMENT.
+static int32_t decodeUtf8(uint8_t c, const uint8_t *str, size_t len, size_t *pos)
+{
+  RA8876Utf8Decoder decoder;
+  int32_t u = decoder.feed(c);
+  while ((u == RA8876_UTF8_PENDING) && (*pos < len))
+  {
+    u = decoder.feed(str[(*pos)++]);
+    if (decoder.unread())
+      (*pos)--;
+  }
+
+  return (u == RA8876_UTF8_PENDING) ? RA8876_UTF8_REPLACEMENT : u;
+}
+
+// Returns the scaled width of the character starting at str[*pos], as write() would
+//  send it, and moves *pos past it.
+int RA8876::charWidth(const uint8_t *str, size_t len, size_t *pos)
+{
+  size_t start = *pos;
+  uint8_t c = str[(*pos)++];
+  int full = (m_fontSize + 2) * 8;
+  int w;
+
+  if ((c == '\r') || (c == '\n'))
+    return 0;
+
+  if (m_fontSource == RA8876_FONT_SOURCE_INTERNAL)
+    return halfWidth(c) * m_textScaleX;  // CGROM is all 8-bit
+
+  if (m_fontSource == RA8876_FONT_SOURCE_BITMAP)
+  {
+    int32_t u = decodeUtf8(c, str, len, pos);
+    RA8876Glyph g;
+    if (!m_bitmapFont->glyph(u, &g))
+      return 0;
+
+    // Include the kerning after the previous character, which writeBitmapText() applies
+    //  once it has decided that this one stays on the same line
+    if (start == 0)
+      return g.xAdvance;
+
+    size_t prev = start - 1;
+    while ((prev > 0) && ((str[prev] & 0xC0) == 0x80))
+      prev--;
+
+    size_t next = prev + 1;
+    return m_bitmapFont->kerning(decodeUtf8(str[prev], str, start, &next), u) + g.xAdvance;
+  }
+
+  if (m_fontSource == RA8876_FONT_SOURCE_USER)
+  {
+    // Codes of 0x8000 and up are two bytes and full width
+    if ((c >= 0x80) && (*pos < len))
+    {
+      (*pos)++;
+      return full * m_textScaleX;
+    }
+
+    return halfWidth(c) * m_textScaleX;
+  }
+
+  if ((m_fontFlags & RA8876_FONT_FLAG_XLAT_FULLWIDTH) && (c >= 0x21) && (c <= 0x7E))
+    return full * m_textScaleX;
+
+  if (m_fontFlags & RA8876_FONT_FLAG_UTF8)
+  {
+    uint16_t code = fontCode(decodeUtf8(c, str, len, pos));
+    if ((code >= 0x100) || ((m_fontEncoding == RA8876_FONT_ENCODING_UNICODE) && (code >= 0x80)))
+      w = full;
+    else
+      w = halfWidth(code);
+
+    return w * m_textScaleX;
+  }
+
+  switch (m_fontEncoding)
+  {
+  case RA8876_FONT_ENCODING_UNICODE:
+    // Bytes pair up into 16-bit codes
+    if (*pos < len)
+    {
+      uint16_t code = (c << 8) | str[(*pos)++];
+      w = (code < 0x80) ? halfWidth(code) : full;
+    }
+    else
+    {
+      w = halfWidth(c);
+    }
+    break;
+  case RA8876_FONT_ENCODING_GB2312:
+  case RA8876_FONT_ENCODING_GB18030:
+  case RA8876_FONT_ENCODING_BIG5:
+  case RA8876_FONT_ENCODING_UNIJAPAN:
+  case RA8876_FONT_ENCODING_JIS0208:
+    // A lead byte of 0x80 or more starts a two-byte full-width character
+    if ((c >= 0x80) && (*pos < len))
+    {
+      (*pos)++;
+      w = full;
+    }
+    else
+    {
+      w = halfWidth(c);
+    }
+    break;
+  default:
+    w = halfWidth(c);
+    break;
+  }
+
+  return w * m_textScaleX;
+}
+
+// Returns the width in pixels that write() would give the text, or of its widest line
+//  if it has several. This is worked out from the font metrics without any bus traffic.
+int RA8876::measureText(const char *str, size_t len)
+{
+  const uint8_t *s = (const uint8_t *) str;
+  int widest = 0;
+  int x = 0;
+
+  size_t pos = 0;
+  while (pos < len)
+  {
+    if (s[pos] == '\n')
+    {
+      widest = max(widest, x);
+      x = 0;
+    }
+
+    x += charWidth(s, len, &pos);
+  }
+
+  return max(widest, x);
+}
+
+// As measureText(), for the 16-bit character codes taken by putChars16().
+int RA8876::measureText16(const uint16_t *str, unsigned int count)
+{
+  int x = 0;
+
+  if (m_fontSource == RA8876_FONT_SOURCE_BITMAP)
+  {
+    // Codes are characters, with kerning between them
+    for (unsigned int i = 0; i < count; i++)
+    {
+      RA8876Glyph g;
+      if (m_bitmapFont->glyph(str[i], &g))
+        x += g.xAdvance + ((i > 0) ? m_bitmapFont->kerning(str[i - 1], str[i]) : 0);
+    }
+
+    return x;
+  }
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if ((m_fontSource == RA8876_FONT_SOURCE_USER) && (str[i] >= 0x8000))
+      x += (m_fontSize + 2) * 8;
+    else if (m_fontSource != RA8876_FONT_SOURCE_EXT_ROM)
+      x += halfWidth(str[i] >> 8) + halfWidth(str[i] & 0xFF);  // Two 8-bit characters
+    else if (str[i] < 0x80)
+      x += halfWidth(str[i]);
+    else
+      x += (m_fontSize + 2) * 8;
+  }
+
+  return x * m_textScaleX;
+}
+
+// Finds how much of the text fits on one line of the given width, breaking after a
+//  space or on either side of a full-width character, or mid-word if one word is too
+//  long for the line. A newline always ends the line. Returns the length of the line,
+//  less any spaces it was broken at, and sets *next to where the following line starts.
+size_t RA8876::fitText(const char *str, size_t len, int width, size_t *next)
+{
+  const uint8_t *s = (const uint8_t *) str;
+  int x = 0;
+
+  size_t breakEnd  = 0;  // Line end and next line start if broken at the last opportunity
+  size_t breakNext = 0;
+
+  size_t pos = 0;
+  while (pos < len)
+  {
+    size_t start = pos;
+
+    if (s[start] == '\n')
+    {
+      *next = start + 1;
+      return start;
+    }
+
+    int w = charWidth(s, len, &pos);
+
+    if (s[start] == ' ')
+    {
+      // Spaces may overhang the edge, as they are dropped if the line breaks there
+      breakEnd  = start;
+      breakNext = pos;
+      x += w;
+      continue;
+    }
+
+    bool wide = (pos - start >= 2) && (w == getTextSizeY() / m_textScaleY * m_textScaleX);
+    if (wide && (start > 0))
+    {
+      breakEnd  = start;
+      breakNext = start;
+    }
+
+    if ((x + w > width) && (start > 0))
+    {
+      if (breakNext == 0)
+      {
+        *next = start;
+        return start;
+      }
+
+      while ((breakEnd > 0) && (s[breakEnd - 1] == ' '))
+        breakEnd--;
+      while ((breakNext < len) && (s[breakNext] == ' '))
+        breakNext++;
+
+      *next = breakNext;
+      return breakEnd;
+    }
+
+    x += w;
+
+    if (wide)
+    {
+      breakEnd  = pos;
+      breakNext = pos;
+    }
+  }
+
+  *next = len;
+  return len;
+}
+
+// Returns the offset from the left of a box of the given width at which to start the
+//  text for the given alignment.
+int RA8876::alignText(const char *str, size_t len, int width, enum TextAlign align)
+{
+  switch (align)
+  {
+  case RA8876_ALIGN_CENTER:
+    return (width - measureText(str, len)) / 2;
+  case RA8876_ALIGN_RIGHT:
+    return width - measureText(str, len);
+  default:
+    return 0;
+  }
+}
+
+// Prints text word-wrapped to a column of the given width, aligning each line within
+//  it. Returns the Y position below the last line.
+int RA8876::printWrapped(int x, int y, int width, const char *str, enum TextAlign align)
+{
+  size_t len = strlen(str);
+  int lineHeight = getTextSizeY();
+
+  size_t pos = 0;
+  while (pos < len)
+  {
+    size_t next;
+    size_t n = fitText(str + pos, len - pos, width, &next);
+
+    setCursor(x + alignText(str + pos, n, width, align), y);
+    write((const uint8_t *) str + pos, n);
+
+    y += lineHeight;
+    pos += next;
+  }
+
+  return y;
+}
+
+void RA8876::setTextScale(int xScale, int yScale)
+{
+  xScale = constrain(xScale, 1, 4);
+  yScale = constrain(yScale, 1, 4);
+
+  m_textScaleX = xScale;
+  m_textScaleY = yScale;
+
+  m_transport->beginTransaction();
+
+  uint8_t ccr1 = readShadowReg(RA8876_REG_CCR1, &m_ccr1);
+  ccr1 = (ccr1 & 0xF0) | ((xScale - 1) << 2) | (yScale - 1);
+  #if defined(RA8876_DEBUG)
+  Serial.println(ccr1, HEX);
+  #endif // RA8876_DEBUG
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1);
+
+  m_transport->endTransaction();
+}
+
+// Writes a byte to the memory port in text mode. Rather than reading the status before
+//  every byte, this counts down the FIFO entries known to be free, and only polls when
+//  that runs out: an empty FIFO frees up its whole depth, one that is merely not full
+//  frees one entry. Callers reset m_fifoFree to 0 when starting a run of writes.
+void RA8876::writeTextData(uint8_t x)
+{
+  while (m_fifoFree == 0)
+  {
+    uint8_t status = readStatus();
+    if (status & 0x40)
+      m_fifoFree = RA8876_WRITE_FIFO_DEPTH;  // Empty
+    else if (!(status & 0x80))
+      m_fifoFree = 1;  // Not full
+  }
+
+  writeData(x);
+  m_fifoFree--;
+}
+
+// Similar to write(), but does no special handling of control characters.
+void RA8876::putChars(const char *buffer, size_t size)
+{
+  int startX = 0, startY = 0;
+  if (m_dirty)
+  {
+    startX = getCursorX();
+    startY = getCursorY();
+  }
+
+  m_transport->beginTransaction();
+
+  setTextMode();
+
+  // Write characters
+  m_fifoFree = 0;
+  writeCmd(RA8876_REG_MRWDP);
+  for (unsigned int i = 0; i < size; i++)
+  {
+    writeTextData(buffer[i]);
+    advanceCursor();
+  }
+
+  setGraphicsMode();
+
+  m_transport->endTransaction();
+
+  if (m_dirty)
+    markTextDirty(startX, startY);
+}
+
+void RA8876::putChars16(const uint16_t *buffer, unsigned int count)
+{
+  int startX = 0, startY = 0;
+  if (m_dirty)
+  {
+    startX = getCursorX();
+    startY = getCursorY();
+  }
+
+  m_transport->beginTransaction();
+
+  setTextMode();
+
+  // Write characters
+  m_fifoFree = 0;
+  writeCmd(RA8876_REG_MRWDP);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    writeTextData(buffer[i] >> 8);
+    writeTextData(buffer[i] & 0xFF);
+
+    // The internal font is 8-bit, so each byte is a character
+    advanceCursor();
+    advanceCursor();
+  }
+
+  setGraphicsMode();
+
+  m_transport->endTransaction();
+
+  if (m_dirty)
+    markTextDirty(startX, startY);
+}
+
+// Sends characters to the text engine, which must already be in text mode, acting on
+//  newlines and carriage returns.
+void RA8876::writeText(const uint8_t *buffer, size_t size)
+{
+  m_fifoFree = 0;
+
+  writeCmd(RA8876_REG_MRWDP);  // Set current register for writing to memory
+  for (unsigned int i = 0; i < size; i++)
+  {
+    int32_t c = buffer[i];
+
+    if (m_fontFlags & RA8876_FONT_FLAG_UTF8)
+    {
+      c = m_utf8.feed(c);
+      if (c == RA8876_UTF8_PENDING)
+        continue;
+      else if (m_utf8.unread())
+        i--;  // Starts the next character
+    }
+
+    if (c == '\r')
+      ;  // Ignored
+    else if (c == '\n')
+    {
+      // Let the characters so far land before moving the cursor (or reading it back)
+      waitWriteFifoEmpty();
+      waitTaskBusy();
+
+      setCursor(0, getCursorY() + getTextSizeY());
+      writeCmd(RA8876_REG_MRWDP);  // Reset current register for writing to memory
+    }
+    else if ((m_fontFlags & RA8876_FONT_FLAG_XLAT_FULLWIDTH) && ((c >= 0x21) && (c <= 0x7E)))
+    {
+      // Translate ASCII to Unicode fullwidth form (for Chinese fonts that lack ASCII)
+      uint16_t fwc = c - 0x21 + 0xFF01;
+
+      writeTextData(fwc >> 8);
+      writeTextData(fwc & 0xFF);
+      advanceCursor();
+    }
+    else if (m_fontFlags & RA8876_FONT_FLAG_UTF8)
+    {
+      uint16_t code = fontCode(c);
+
+      // Unicode is always 16-bit; the other encodings keep ASCII as single bytes
+      if ((code >= 0x100) || (m_fontEncoding == RA8876_FONT_ENCODING_UNICODE))
+        writeTextData(code >> 8);
+      writeTextData(code & 0xFF);
+      advanceCursor();
+    }
+    else
+    {
+      writeTextData(c);
+      advanceCursor();
+    }
+  }
+}
+
+// Converts a Unicode character to a code in the current font encoding: directly for
+//  the Unicode encoding, and through the table given to setUnicodeMap() for others.
+//  ISO 8859-1 characters pass through for that encoding. Anything else, including the
+//  replacement for malformed UTF-8, becomes '?'.
+uint16_t RA8876::fontCode(uint32_t c)
+{
+  if (c < 0x80)
+    return c;
+  else if (c == RA8876_UTF8_REPLACEMENT)
+    return '?';
+
+  if (m_fontEncoding == RA8876_FONT_ENCODING_UNICODE)
+    return (c <= 0xFFFF) ? c : '?';
+
+  if (m_unicodeMap && (c <= 0xFFFF))
+  {
+    uint16_t code = ra8876UnicodeLookup(m_unicodeMap, m_unicodeMapSize, c);
+    if (code)
+      return code;
+  }
+
+  if ((c <= 0xFF) && (m_fontEncoding == RA8876_FONT_ENCODING_8859_1))
+    return c;
 
-  SPI.endTransaction();
+  return '?';
 }
 
-void RA8876::selectExternalFont(enum ExternalFontFamily family, enum FontSize size, enum FontEncoding enc, FontFlags flags)
+// Glyph cache slots are laid out in rows of this many cells.
+#define RA8876_GLYPH_CACHE_COLUMNS 32
+
+// Starts caching external font ROM glyphs in SDRAM, so that each character is fetched
+//  from the ROM once and then drawn by BTE colour expansion. The bitmaps are packed
+//  into pixels of the canvas depth, which must be 8 or 16 bits and stay the same while
+//  the cache is in use. Passing 0 frees the SDRAM again.
+bool RA8876::setGlyphCache(RA8876GlyphCache *cache)
 {
-  m_fontSource = RA8876_FONT_SOURCE_EXT_ROM;
-  m_fontSize   = size;
-  m_fontFlags  = flags;
+  if (m_glyphCache)
+  {
+    freeSurface(&m_glyphBitmaps);
+    freeSurface(&m_glyphScratch);
+    m_glyphCache = 0;
+  }
 
-  SPI.beginTransaction(m_spiSettings);
+  if (!cache)
+    return true;
 
-  #if defined(RA8876_DEBUG)
-  Serial.print("CCR0: "); Serial.println(0x40 | ((size & 0x03) << 4), HEX);
-  #endif // RA8876_DEBUG
-  writeReg(RA8876_REG_CCR0, 0x40 | ((size & 0x03) << 4));  // Select external font ROM and size
+  if ((m_canvasDepth != 8) && (m_canvasDepth != 16))
+    return false;
 
-  uint8_t ccr1 = readReg(RA8876_REG_CCR1);
-  ccr1 |= 0x40;  // Transparent background
-  #if defined(RA8876_DEBUG)
-  Serial.print("CCR1: "); Serial.println(ccr1, HEX);
-  #endif // RA8876_DEBUG
-  writeReg(RA8876_REG_CCR1, ccr1);
+  int columns = min(RA8876_GLYPH_CACHE_SLOTS, RA8876_GLYPH_CACHE_COLUMNS);
+  int rows    = (RA8876_GLYPH_CACHE_SLOTS + RA8876_GLYPH_CACHE_COLUMNS - 1) / RA8876_GLYPH_CACHE_COLUMNS;
+  int units   = RA8876_GLYPH_CELL / m_canvasDepth;  // Pixels per cell row
 
-  #if defined(RA8876_DEBUG)
-  Serial.print("GTFNT_CR: "); Serial.println((enc << 3) | (family & 0x03), HEX);
-  #endif // RA8876_DEBUG
-  writeReg(RA8876_REG_GTFNT_CR, (enc << 3) | (family & 0x03));  // Character encoding and family
+  if (!allocSurface(columns * units, rows * RA8876_GLYPH_CELL, &m_glyphBitmaps))
+    return false;
 
-  SPI.endTransaction();
+  if (!allocSurface(RA8876_GLYPH_CELL, RA8876_GLYPH_CELL, &m_glyphScratch))
+  {
+    freeSurface(&m_glyphBitmaps);
+    return false;
+  }
+
+  cache->clear();
+  m_glyphCache = cache;
+
+  return true;
 }
 
-int RA8876::getTextSizeY(void)
+// True if text in the current font can be drawn from the glyph cache. Scaled text
+//  and other canvas depths go to the text engine as usual.
+bool RA8876::useGlyphCache(void)
 {
-  return ((m_fontSize + 2) * 8) * m_textScaleY;
+  if (!m_glyphCache || (m_fontSource != RA8876_FONT_SOURCE_EXT_ROM))
+    return false;
+  else if ((m_textScaleX != 1) || (m_textScaleY != 1))
+    return false;
+  else if ((m_canvasDepth != m_glyphBitmaps.depth) || !m_canvasWidth)
+    return false;
+
+  m_glyphCache->setFont(1 | (m_fontSize << 8) | ((uint32_t) m_fontFamily << 16) | ((uint32_t) m_fontEncoding << 24));
+
+  return true;
 }
 
-void RA8876::setTextScale(int xScale, int yScale)
+// Fetches a glyph from the font ROM into the cache, and returns its slot. The chip
+//  can only render text in colour, so the glyph is drawn white on black in the scratch
+//  cell, read back, and written to its slot one bit per pixel. Its width comes from
+//  the cursor advance, which covers the proportional families too.
+int RA8876::cacheGlyph(uint16_t code, bool wide)
 {
-  xScale = constrain(xScale, 1, 4);
-  yScale = constrain(yScale, 1, 4);
+  int height = (m_fontSize + 2) * 8;
+  int bits   = m_canvasDepth;
+  int units  = RA8876_GLYPH_CELL / bits;  // Pixels per cell row
+  uint16_t bitmap[RA8876_GLYPH_CELL * (RA8876_GLYPH_CELL / 8)];
 
-  m_textScaleX = xScale;
-  m_textScaleY = yScale;
+  waitPendingTask();
 
-  SPI.beginTransaction(m_spiSettings);
+  // Render into the scratch cell, on an opaque background
+  writeReg32(RA8876_REG_CVSSA0, m_glyphScratch.address);
+  writeReg16(RA8876_REG_CVS_IMWTH0, m_glyphScratch.width);
+  writeActiveWindow(0, 0, RA8876_GLYPH_CELL, RA8876_GLYPH_CELL);
 
-  uint8_t ccr1 = readReg(RA8876_REG_CCR1);
-  ccr1 = (ccr1 & 0xF0) | ((xScale - 1) << 2) | (yScale - 1);
-  #if defined(RA8876_DEBUG)
-  Serial.println(ccr1, HEX);
-  #endif // RA8876_DEBUG
-  writeReg(RA8876_REG_CCR1, ccr1);
+  uint8_t ccr1 = readShadowReg(RA8876_REG_CCR1, &m_ccr1);
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1 & ~0x40);
+
+  setForegroundColor(0xFFFF);
+  setKeyColor(0x0000);  // Background
+
+  writeReg16(RA8876_REG_F_CURX0, 0);
+  writeReg16(RA8876_REG_F_CURY0, 0);
+
+  uint8_t icr = readShadowReg(RA8876_REG_ICR, &m_icr);
+  writeShadowReg(RA8876_REG_ICR, &m_icr, icr | 0x04);
+
+  writeCmd(RA8876_REG_MRWDP);
+  if (wide)
+    writeData(code >> 8);
+  writeData(code & 0xFF);
+
+  waitWriteFifoEmpty();
+  waitTaskBusy();
+
+  int width = min((int) readReg16(RA8876_REG_F_CURX0), RA8876_GLYPH_CELL);
+
+  writeShadowReg(RA8876_REG_ICR, &m_icr, icr);
+
+  // Read it back, with the window narrowed to the glyph so that the memory cursor
+  //  wraps at its right edge. A 16-bit bus reads a whole 16 bpp pixel per cycle.
+  memset(bitmap, 0, sizeof(bitmap));
+
+  bool wideBus = (bits == 16) && m_transport->is16Bit();
+
+  writeActiveWindow(0, 0, max(width, 1), height);
+  writeReg16(RA8876_REG_CURH0, 0);
+  writeReg16(RA8876_REG_CURV0, 0);
+
+  writeCmd(RA8876_REG_MRWDP);
+  readData();  // Dummy read
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      uint16_t on = 0;
+      if (wideBus)
+        on = m_transport->readData16();
+      else
+        for (int k = 0; k < bits / 8; k++)
+          on |= readData();
+
+      if (on)
+        bitmap[(y * units) + (x / bits)] |= 1 << (bits - 1 - (x % bits));
+    }
+  }
+
+  // Write it to its slot
+  int slot = m_glyphCache->insert(code, width);
+  int sx = (slot % RA8876_GLYPH_CACHE_COLUMNS) * units;
+  int sy = (slot / RA8876_GLYPH_CACHE_COLUMNS) * RA8876_GLYPH_CELL;
+
+  writeReg32(RA8876_REG_CVSSA0, m_glyphBitmaps.address);
+  writeReg16(RA8876_REG_CVS_IMWTH0, m_glyphBitmaps.width);
+  writeActiveWindow(sx, sy, units, height);
+  writeReg16(RA8876_REG_CURH0, sx);
+  writeReg16(RA8876_REG_CURV0, sy);
+
+  int chunk = wideBus ? RA8876_WRITE_FIFO_DEPTH : (RA8876_WRITE_FIFO_DEPTH / (bits / 8));
+
+  writeCmd(RA8876_REG_MRWDP);
+  for (int i = 0; i < units * height; i++)
+  {
+    if ((i % chunk) == 0)
+      waitWriteFifoEmpty();
+
+    if (bits == 16)
+      m_transport->writeData16(bitmap[i]);
+    else
+      writeData(bitmap[i]);
+  }
+
+  waitWriteFifoEmpty();
+
+  // Put the canvas and text settings back
+  writeReg32(RA8876_REG_CVSSA0, m_canvasAddress);
+  writeReg16(RA8876_REG_CVS_IMWTH0, m_canvasWidth);
+  writeActiveWindow(m_windowX, m_windowY, m_windowWidth, m_windowHeight);
+  writeShadowReg(RA8876_REG_CCR1, &m_ccr1, ccr1);
+  setForegroundColor(m_textColor);
 
-  SPI.endTransaction();
+  return slot;
 }
 
-// Similar to write(), but does no special handling of control characters.
-void RA8876::putChars(const char *buffer, size_t size)
+// Colour expands a cached glyph onto the canvas at (x, y). Only set bits are drawn, as
+//  the select*Font() calls ask for a transparent background.
+void RA8876::drawCachedGlyph(int slot, int x, int y)
 {
-  SPI.beginTransaction(m_spiSettings);
+  int units = RA8876_GLYPH_CELL / m_canvasDepth;
+  int sx = (slot % RA8876_GLYPH_CACHE_COLUMNS) * units;
+  int sy = (slot / RA8876_GLYPH_CACHE_COLUMNS) * RA8876_GLYPH_CELL;
 
-  setTextMode();
+  bteExpand(sx, sy, x, y, m_glyphCache->width(slot), (m_fontSize + 2) * 8);
+}
 
-  // Write characters
-  writeCmd(RA8876_REG_MRWDP);
-  for (unsigned int i = 0; i < size; i++)
+// As writeText(), but in graphics mode, drawing each character from the glyph cache
+//  and fetching the ones it doesn't have yet. The cursor is tracked in software and
+//  only written back to the chip before the text engine is next used.
+void RA8876::writeCachedText(const uint8_t *buffer, size_t size)
+{
+  int height = (m_fontSize + 2) * 8;
+
+  beginExpand(&m_glyphBitmaps);
+  setForegroundColor(m_textColor);
+
+  for (size_t i = 0; i < size; i++)
   {
-    waitWriteFifo();
-    writeData(buffer[i]);
+    int32_t c = buffer[i];
+    uint16_t code;
+    bool wide;
+
+    if (m_fontFlags & RA8876_FONT_FLAG_UTF8)
+    {
+      c = m_utf8.feed(c);
+      if (c == RA8876_UTF8_PENDING)
+        continue;
+      else if (m_utf8.unread())
+        i--;  // Starts the next character
+    }
+
+    if (m_glyphLead >= 0)
+    {
+      code = (m_glyphLead << 8) | c;
+      wide = true;
+      m_glyphLead = -1;
+    }
+    else if (c == '\r')
+    {
+      continue;  // Ignored
+    }
+    else if (c == '\n')
+    {
+      m_cursorX = 0;
+      m_cursorY += height;
+      continue;
+    }
+    else if ((m_fontFlags & RA8876_FONT_FLAG_XLAT_FULLWIDTH) && ((c >= 0x21) && (c <= 0x7E)))
+    {
+      code = c - 0x21 + 0xFF01;
+      wide = true;
+    }
+    else if (m_fontFlags & RA8876_FONT_FLAG_UTF8)
+    {
+      code = fontCode(c);
+      wide = (code >= 0x100) || (m_fontEncoding == RA8876_FONT_ENCODING_UNICODE);
+    }
+    else
+    {
+      // Raw bytes pair up as the text engine would pair them
+      bool lead = (m_fontEncoding == RA8876_FONT_ENCODING_UNICODE) ||
+                  ((c >= 0x80) && ((m_fontEncoding == RA8876_FONT_ENCODING_GB2312) ||
+                                   (m_fontEncoding == RA8876_FONT_ENCODING_GB18030) ||
+                                   (m_fontEncoding == RA8876_FONT_ENCODING_BIG5) ||
+                                   (m_fontEncoding == RA8876_FONT_ENCODING_UNIJAPAN) ||
+                                   (m_fontEncoding == RA8876_FONT_ENCODING_JIS0208)));
+      if (lead)
+      {
+        m_glyphLead = c;
+        continue;
+      }
+
+      code = c;
+      wide = false;
+    }
+
+    int slot = m_glyphCache->find(code);
+    if (slot < 0)
+      slot = cacheGlyph(code, wide);
+
+    int width = m_glyphCache->width(slot);
+
+    // Wrap at the canvas window edge, as the text engine does
+    if (m_cursorX + width > m_windowX + m_windowWidth)
+    {
+      m_cursorX = m_windowX;
+      m_cursorY += height;
+    }
+
+    drawCachedGlyph(slot, m_cursorX, m_cursorY);
+    m_cursorX += width;
   }
 
-  setGraphicsMode();
+  m_cursorStale = true;
+}
 
-  SPI.endTransaction();
+// Coverage of pixel (x, y) of a glyph bitmap.
+static int glyphPixel(const RA8876Font *font, const RA8876Glyph *g, int x, int y)
+{
+  uint32_t bit = ((uint32_t) y * g->width + x) * font->bpp;
+  uint8_t b = pgm_read_byte(font->bitmap + g->bitmapOffset + (bit / 8));
+
+  return (b >> (8 - font->bpp - (bit % 8))) & ((1 << font->bpp) - 1);
 }
 
-void RA8876::putChars16(const uint16_t *buffer, unsigned int count)
+static int countBits(uint16_t x)
 {
-  SPI.beginTransaction(m_spiSettings);
+  int n = 0;
+  for (; x; x &= x - 1)
+    n++;
 
-  setTextMode();
+  return n;
+}
 
-  // Write characters
-  writeCmd(RA8876_REG_MRWDP);
-  for (unsigned int i = 0; i < count; i++)
+// Copies a font into SDRAM for drawing with selectBitmapFont(), recording where each
+//  glyph went in the atlas. The glyphs are split into one plane per coverage level they
+//  use, so that the BTE can colour expand each level in its own shade. The canvas
+//  depth must be 8 or 16 bits and stay the same while the font is in use.
+bool RA8876::loadFont(const RA8876Font *font, RA8876FontAtlas *atlas)
+{
+  freeFont(atlas);
+
+  if ((m_canvasDepth != 8) && (m_canvasDepth != 16))
+    return false;
+  else if ((font->bpp != 1) && (font->bpp != 2) && (font->bpp != 4))
+    return false;
+  else if ((font->last < font->first) || (font->last - font->first >= RA8876_FONT_MAX_GLYPHS))
+    return false;
+
+  int bits = m_canvasDepth;
+
+  atlas->begin(font);
+
+  // Lay the planes out left to right in bands as tall as their tallest glyph
+  int x = 0, y = 0;
+  int bandHeight = 0;
+  int width = 4;
+  for (uint32_t c = font->first; c <= font->last; c++)
   {
-    waitWriteFifo();
-    writeData(buffer[i] >> 8);
+    RA8876Glyph g;
+    atlas->glyph(c, &g);
 
-    waitWriteFifo();
-    writeData(buffer[i] & 0xFF);
+    RA8876FontAtlas::Placement *p = atlas->placement(c);
+    p->levels = 0;
+    for (int gy = 0; gy < g.height; gy++)
+    {
+      for (int gx = 0; gx < g.width; gx++)
+      {
+        int level = glyphPixel(font, &g, gx, gy);
+        if (level)
+          p->levels |= 1 << (level - 1);
+      }
+    }
+
+    int need = countBits(p->levels) * ((g.width + bits - 1) / bits);
+    if (x + need > RA8876_FONT_ATLAS_WIDTH)
+    {
+      x = 0;
+      y += bandHeight;
+      bandHeight = 0;
+    }
+
+    p->x = x;
+    p->y = y;
+
+    x += need;
+    width = max(width, x);
+    if (need)
+      bandHeight = max(bandHeight, (int) g.height);
   }
 
-  setGraphicsMode();
+  SdramSurface surface;
+  if (!allocSurface(width, max(y + bandHeight, 1), &surface))
+  {
+    atlas->end();
+    return false;
+  }
+
+  atlas->setSurface(&surface);
+
+  m_transport->beginTransaction();
+
+  waitPendingTask();
+
+  writeReg32(RA8876_REG_CVSSA0, surface.address);
+  writeReg16(RA8876_REG_CVS_IMWTH0, surface.width);
+
+  for (uint32_t c = font->first; c <= font->last; c++)
+  {
+    RA8876Glyph g;
+    atlas->glyph(c, &g);
+    writeGlyphPlanes(font, &g, atlas->placement(c));
+  }
+
+  writeReg32(RA8876_REG_CVSSA0, m_canvasAddress);
+  writeReg16(RA8876_REG_CVS_IMWTH0, m_canvasWidth);
+  writeActiveWindow(m_windowX, m_windowY, m_windowWidth, m_windowHeight);
+
+  m_transport->endTransaction();
 
-  SPI.endTransaction();
+  return true;
 }
 
-size_t RA8876::write(const uint8_t *buffer, size_t size)
+// Writes the planes of one glyph to the atlas, which must be the canvas. Each plane
+//  streams through an active window just its size, a row of packed pixels at a time.
+void RA8876::writeGlyphPlanes(const RA8876Font *font, const RA8876Glyph *g, const RA8876FontAtlas::Placement *p)
 {
-  SPI.beginTransaction(m_spiSettings);
+  int bits  = m_canvasDepth;
+  int units = (g->width + bits - 1) / bits;
+  bool wideBus = (bits == 16) && m_transport->is16Bit();
+  int chunk = wideBus ? RA8876_WRITE_FIFO_DEPTH : (RA8876_WRITE_FIFO_DEPTH / (bits / 8));
 
-  setTextMode();
+  int x = p->x;
+  for (int level = 1; level <= 15; level++)
+  {
+    if (!(p->levels & (1 << (level - 1))))
+      continue;
 
-  writeCmd(RA8876_REG_MRWDP);  // Set current register for writing to memory
-  for (unsigned int i = 0; i < size; i++)
+    writeActiveWindow(x, p->y, units, g->height);
+    writeReg16(RA8876_REG_CURH0, x);
+    writeReg16(RA8876_REG_CURV0, p->y);
+
+    writeCmd(RA8876_REG_MRWDP);
+    int n = 0;
+    for (int gy = 0; gy < g->height; gy++)
+    {
+      for (int u = 0; u < units; u++)
+      {
+        uint16_t unit = 0;
+        for (int b = 0; b < bits; b++)
+        {
+          int gx = (u * bits) + b;
+          if ((gx < g->width) && (glyphPixel(font, g, gx, gy) == level))
+            unit |= 1 << (bits - 1 - b);
+        }
+
+        if ((n++ % chunk) == 0)
+          waitWriteFifoEmpty();
+
+        if (bits == 16)
+          m_transport->writeData16(unit);
+        else
+          writeData(unit);
+      }
+    }
+
+    waitWriteFifoEmpty();
+
+    x += units;
+  }
+}
+
+void RA8876::freeFont(RA8876FontAtlas *atlas)
+{
+  if ((m_fontSource == RA8876_FONT_SOURCE_BITMAP) && (m_bitmapFont == atlas))
+    selectInternalFont(RA8876_FONT_SIZE_16);
+
+  if (atlas->surface()->address != RA8876_SDRAM_NONE)
+    m_sdram.free(atlas->surface()->address);
+
+  atlas->end();
+}
+
+// Selects a font loaded with loadFont() for text output. Anti-aliased fonts are blended
+//  towards the given background colour, so they suit text on a plain background;
+//  1bpp fonts are drawn transparently over whatever is there.
+void RA8876::selectBitmapFont(const RA8876FontAtlas *atlas, uint16_t background)
+{
+  m_fontSource   = RA8876_FONT_SOURCE_BITMAP;
+  m_fontSize     = RA8876_FONT_SIZE_16;
+  m_fontFlags    = RA8876_FONT_FLAG_UTF8;
+  m_fontFamily   = RA8876_FONT_FAMILY_FIXED;
+  m_fontEncoding = RA8876_FONT_ENCODING_UNICODE;
+
+  m_bitmapFont       = atlas;
+  m_bitmapBackground = rgb565To888(background);
+  m_kernLeft         = 0;
+
+  m_utf8.reset();
+}
+
+// Draws a run of laid-out glyphs, level by level: each level of coverage is the text
+//  colour mixed with the background in proportion, set once, and then that level's
+//  plane of every glyph that has it is expanded. Where glyphs overlap, the higher
+//  coverage shows. The BTE expands one colour at a time, so an anti-aliased glyph still
+//  takes an expansion for each level it has; only the colour setup is shared.
+void RA8876::drawBitmapGlyphs(const GlyphDraw *run, int count)
+{
+  int bits = m_canvasDepth;
+  int top  = (1 << m_bitmapFont->font()->bpp) - 1;
+  uint32_t fg = rgb565To888(m_textColor);
+  uint32_t bg = m_bitmapBackground;
+
+  for (int level = 1; level <= top; level++)
   {
-    char c = buffer[i];
+    uint16_t bit = 1 << (level - 1);
+    bool colorSet = false;
 
-    if (c == '\r')
-      ;  // Ignored
-    else if (c == '\n')
+    for (int i = 0; i < count; i++)
     {
-      setCursor(0, getCursorY() + getTextSizeY());
-      writeCmd(RA8876_REG_MRWDP);  // Reset current register for writing to memory
+      const GlyphDraw *d = &run[i];
+      if (!(d->placement->levels & bit))
+        continue;
+
+      if (!colorSet)
+      {
+        uint32_t rgb = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+          uint32_t f = (fg >> shift) & 0xFF;
+          uint32_t b = (bg >> shift) & 0xFF;
+          rgb |= (((f * level) + (b * (top - level)) + (top / 2)) / top) << shift;
+        }
+
+        waitPendingTask();
+        setForegroundRgb(rgb);
+        colorSet = true;
+      }
+
+      // The glyph's planes lie side by side, one for each level it has, lowest first
+      int plane = 0;
+      for (uint16_t lower = d->placement->levels & (bit - 1); lower; lower &= lower - 1)
+        plane++;
+
+      int units = (d->width + bits - 1) / bits;
+      bteExpand(d->placement->x + (plane * units), d->placement->y, d->x, d->y, d->width, d->height);
     }
-    else if ((m_fontFlags & RA8876_FONT_FLAG_XLAT_FULLWIDTH) && ((c >= 0x21) || (c <= 0x7F)))
+  }
+}
+
+// As writeText(), for the bitmap font: decodes UTF-8 and lays the glyphs out, applying
+//  kerning and wrapping at the canvas window edge, then draws them with the BTE in runs.
+//  The cursor is at the top of the line, and the glyphs hang from the font's baseline
+//  below it.
+void RA8876::writeBitmapText(const uint8_t *buffer, size_t size)
+{
+  const RA8876Font *font = m_bitmapFont->font();
+  GlyphDraw run[RA8876_FONT_RUN];
+  int count = 0;
+
+  beginExpand(m_bitmapFont->surface());
+
+  for (size_t i = 0; i < size; i++)
+  {
+    int32_t c = m_utf8.feed(buffer[i]);
+    if (c == RA8876_UTF8_PENDING)
+      continue;
+    else if (m_utf8.unread())
+      i--;  // Starts the next character
+
+    if (c == '\r')
+      continue;  // Ignored
+
+    if (c == '\n')
     {
-      // Translate ASCII to Unicode fullwidth form (for Chinese fonts that lack ASCII)
-      uint16_t fwc = c - 0x21 + 0xFF01;
+      m_cursorX  = 0;
+      m_cursorY += font->yAdvance;
+      m_kernLeft = 0;
+      continue;
+    }
 
-      waitWriteFifo();
-      writeData(fwc >> 8);
+    RA8876Glyph g;
+    if (!m_bitmapFont->glyph(c, &g))
+      continue;
 
-      waitWriteFifo();
-      writeData(fwc & 0xFF);
+    // Kerning only applies between glyphs that end up on the same line
+    int kern = m_kernLeft ? m_bitmapFont->kerning(m_kernLeft, c) : 0;
+
+    if (m_cursorX + kern + g.xAdvance > m_windowX + m_windowWidth)
+    {
+      m_cursorX  = m_windowX;
+      m_cursorY += font->yAdvance;
     }
     else
     {
-      waitWriteFifo();
-      writeData(c);
+      m_cursorX += kern;
+    }
+
+    if (g.width && g.height)
+    {
+      if (count == RA8876_FONT_RUN)
+      {
+        drawBitmapGlyphs(run, count);
+        count = 0;
+      }
+
+      run[count].x         = m_cursorX + g.xOffset;
+      run[count].y         = m_cursorY + font->baseline + g.yOffset;
+      run[count].width     = g.width;
+      run[count].height    = g.height;
+      run[count].placement = m_bitmapFont->placement(c);
+      count++;
     }
+
+    m_cursorX += g.xAdvance;
+    m_kernLeft = c;
+  }
+
+  drawBitmapGlyphs(run, count);
+
+  m_cursorStale = true;
+}
+
+size_t RA8876::write(const uint8_t *buffer, size_t size)
+{
+  if (m_fontSource == RA8876_FONT_SOURCE_BITMAP)
+  {
+    if ((m_canvasDepth != m_bitmapFont->surface()->depth) || !m_canvasWidth)
+      return 0;  // The atlas is packed for another depth
+
+    syncCursor();
+
+    m_transport->beginTransaction();
+    writeBitmapText(buffer, size);
+    m_transport->endTransaction();
+
+    return size;
+  }
+  else if (useGlyphCache())
+  {
+    syncCursor();
+
+    m_transport->beginTransaction();
+    writeCachedText(buffer, size);
+    m_transport->endTransaction();
+
+    return size;
+  }
+
+  // The text engine's cursor has to be read back to mark where the text went; the paths
+  //  above mark each glyph as they draw it
+  int startX = 0, startY = 0;
+  if (m_dirty)
+  {
+    startX = getCursorX();
+    startY = getCursorY();
   }
 
+  m_transport->beginTransaction();
+
+  setTextMode();
+
+  writeText(buffer, size);
+
   setGraphicsMode();
 
-  SPI.endTransaction();
+  m_transport->endTransaction();
+
+  if (m_dirty)
+    markTextDirty(startX, startY);
 
   return size;
 }
+
+// Replays a recorded display list, in the order planned for the current font and
+//  canvas window, switching between graphics and text mode only where the plan does.
+//  Text in a bitmap font, or from the glyph cache, goes through write() as it would
+//  have live.
+void RA8876::drawList(RA8876DisplayList *list)
+{
+  int lineHeight = getTextSizeY();
+  int advance    = lineHeight / m_textScaleY * m_textScaleX;  // Full-width ROM glyph
+  int overhang   = 0;
+  if (m_fontSource == RA8876_FONT_SOURCE_BITMAP)
+  {
+    advance  = m_bitmapFont->maxAdvance();
+    overhang = m_bitmapFont->overhang();
+  }
+
+  DirtyRect window;
+  window.x1 = m_windowX;
+  window.y1 = m_windowY;
+  window.x2 = m_windowX + m_windowWidth - 1;
+  window.y2 = m_windowY + m_windowHeight - 1;
+
+  int count = list->plan(advance, lineHeight, overhang, &window);
+
+  uint16_t textColor = m_textColor;
+  bool textMode = false;
+
+  m_transport->beginTransaction();
+
+  for (int i = 0; i < count; i++)
+  {
+    const DisplayOp *op = list->planOp(i);
+
+    if ((op->type == RA8876_OP_TEXT) && ((m_fontSource == RA8876_FONT_SOURCE_BITMAP) || useGlyphCache()))
+    {
+      // Drawn with the BTE in graphics mode, as write() does for these fonts
+      if (textMode)
+      {
+        setGraphicsMode();
+        textMode = false;
+      }
+
+      m_textColor = op->color;
+      if (op->x1 != RA8876_DL_CONTINUE)
+        setCursor(op->x1, op->y1);
+
+      write((const uint8_t *) list->text(op), op->y2);
+
+      continue;
+    }
+    else if (op->type == RA8876_OP_TEXT)
+    {
+      if (!textMode)
+      {
+        m_textColor = op->color;
+        setTextMode();
+        textMode = true;
+      }
+      else if (op->color != m_textColor)
+      {
+        // Let queued characters render in the old colour first
+        waitWriteFifoEmpty();
+        waitTaskBusy();
+
+        m_textColor = op->color;
+        setForegroundColor(m_textColor);
+      }
+
+      if (op->x1 != RA8876_DL_CONTINUE)
+      {
+        waitTaskBusy();
+        setCursor(op->x1, op->y1);
+      }
+
+      int startX = 0, startY = 0;
+      if (m_dirty)
+      {
+        waitTaskBusy();
+        startX = getCursorX();
+        startY = getCursorY();
+      }
+
+      writeText((const uint8_t *) list->text(op), op->y2);
+
+      if (m_dirty)
+      {
+        waitWriteFifoEmpty();
+        waitTaskBusy();
+        markTextDirty(startX, startY);
+      }
+
+      continue;
+    }
+
+    if (textMode)
+    {
+      setGraphicsMode();
+      textMode = false;
+    }
+
+    switch (op->type)
+    {
+    case RA8876_OP_LINE:
+      drawLine(op->x1, op->y1, op->x2, op->y2, op->color);
+      break;
+    case RA8876_OP_RECT:
+      drawRect(op->x1, op->y1, op->x2, op->y2, op->color);
+      break;
+    case RA8876_OP_FILL_RECT:
+      fillRect(op->x1, op->y1, op->x2, op->y2, op->color);
+      break;
+    case RA8876_OP_CIRCLE:
+      drawCircle(op->x1, op->y1, op->x2, op->color);
+      break;
+    case RA8876_OP_FILL_CIRCLE:
+      fillCircle(op->x1, op->y1, op->x2, op->color);
+      break;
+    case RA8876_OP_CLEAR:
+      clearScreen(op->color);
+      break;
+    }
+  }
+
+  if (textMode)
+    setGraphicsMode();
+
+  m_textColor = textColor;
+
+  m_transport->endTransaction();
+}
@@ -6,7 +6,16 @@
 #include <Arduino.h>
 #include <SPI.h>
 
+#include "RA8876Transport.h"
+#include "RA8876Sdram.h"
+#include "RA8876Dirty.h"
+#include "RA8876DisplayList.h"
+#include "RA8876Unicode.h"
+#include "RA8876GlyphCache.h"
+#include "RA8876Font.h"
+
 //#define RA8876_DEBUG // Uncomment to enable debug messaging
+//#define RA8876_VERIFY_SHADOW // Uncomment to check shadowed registers against the chip
 
 struct SdramInfo
 {
@@ -51,7 +60,9 @@ struct PllParams
 enum FontSource
 {
   RA8876_FONT_SOURCE_INTERNAL,  // CGROM with four 8-bit ISO Latin variants
-  RA8876_FONT_SOURCE_EXT_ROM    // External font ROM chip
+  RA8876_FONT_SOURCE_EXT_ROM,   // External font ROM chip
+  RA8876_FONT_SOURCE_USER,      // User-defined glyphs in SDRAM (CGRAM)
+  RA8876_FONT_SOURCE_BITMAP     // Host-converted font in SDRAM, drawn by the BTE (loadFont())
 };
 
 enum FontSize
@@ -119,8 +130,44 @@ enum ExternalFontFamily
   RA8876_FONT_FAMILY_FIXED_BOLD = 3
 };
 
+// Raster operations for block transfers, combining source 0 (S0) with source 1 (S1)
+//  bitwise. For copies, S1 is the destination. See data sheet section 12.
+enum BteRop
+{
+  RA8876_ROP_BLACK          = 0x0,  // 0
+  RA8876_ROP_NOR            = 0x1,  // ~(S0 | S1)
+  RA8876_ROP_NOT_S0_AND_S1  = 0x2,  // ~S0 & S1
+  RA8876_ROP_NOT_S0         = 0x3,  // ~S0
+  RA8876_ROP_S0_AND_NOT_S1  = 0x4,  // S0 & ~S1
+  RA8876_ROP_NOT_S1         = 0x5,  // ~S1
+  RA8876_ROP_XOR            = 0x6,  // S0 ^ S1
+  RA8876_ROP_NAND           = 0x7,  // ~(S0 & S1)
+  RA8876_ROP_AND            = 0x8,  // S0 & S1
+  RA8876_ROP_XNOR           = 0x9,  // ~(S0 ^ S1)
+  RA8876_ROP_S1             = 0xA,  // S1 (destination unchanged)
+  RA8876_ROP_NOT_S0_OR_S1   = 0xB,  // ~S0 | S1
+  RA8876_ROP_S0             = 0xC,  // S0 (plain copy)
+  RA8876_ROP_S0_OR_NOT_S1   = 0xD,  // S0 | ~S1
+  RA8876_ROP_OR             = 0xE,  // S0 | S1
+  RA8876_ROP_WHITE          = 0xF   // 1
+};
+
 typedef uint8_t FontFlags;
 #define RA8876_FONT_FLAG_XLAT_FULLWIDTH 0x01  // Translate ASCII to Unicode fullwidth forms
+#define RA8876_FONT_FLAG_UTF8           0x02  // Text is UTF-8, converted to the font encoding
+
+enum TextAlign
+{
+  RA8876_ALIGN_LEFT,
+  RA8876_ALIGN_CENTER,
+  RA8876_ALIGN_RIGHT
+};
+
+// Maximum number of pages for page flipping.
+#define RA8876_MAX_PAGES 4
+
+// Depth of the host memory write FIFO, in bus cycles.
+#define RA8876_WRITE_FIFO_DEPTH 16
 
 //enum CanvasMode
 //{
@@ -128,19 +175,6 @@ typedef uint8_t FontFlags;
 // RA8876_CANVAS_BLOCK
 //};
 
-// 1MHz. TODO: Figure out actual speed to use
-// Data sheet section 5.2 says maximum SPI clock is 50MHz.
-#define RA8876_SPI_SPEED 1000000
-
-// With SPI, the RA8876 expects an initial byte where the top two bits are meaningful. Bit 7
-// is A0, bit 6 is WR#. See data sheet section 7.3.2 and section 19.
-// A0: 0 for command/status, 1 for data
-// WR#: 0 for write, 1 for read
-#define RA8876_DATA_WRITE  0x80
-#define RA8876_DATA_READ   0xC0
-#define RA8876_CMD_WRITE   0x00
-#define RA8876_STATUS_READ 0x40
-
 // Data sheet 19.2: Chip configuration registers
 #define RA8876_REG_SRR     0x00  // Software Reset Register
 #define RA8876_REG_CCR     0x01  // Chip Configuration Register
@@ -156,6 +190,10 @@ typedef uint8_t FontFlags;
 #define RA8876_REG_SPLLC1  0x09  // CCLK PLL control register 1
 #define RA8876_REG_SPLLC2  0x0A  // CCLK PLL control register 2
 
+// Data sheet 19.4: Interrupt control registers
+#define RA8876_REG_INTEN   0x0B  // Interrupt Enable Register
+#define RA8876_REG_INTF    0x0C  // Interrupt Event Flag Register
+
 // Data sheet 19.5: LCD display control registers
 #define RA8876_REG_MPWCTR  0x10  // Main/PIP Window Control Register
 #define RA8876_REG_PIPCDEP 0x11  // PIP Window Color Depth register
@@ -183,6 +221,24 @@ typedef uint8_t FontFlags;
 #define RA8876_REG_MWULX1  0x27  // Main Window Upper-Left X coordinate 1
 #define RA8876_REG_MWULY0  0x28  // Main Window Upper-Left Y coordinate 0
 #define RA8876_REG_MWULY1  0x29  // Main Window Upper-Left Y coordinate 1
+#define RA8876_REG_PWDULX0 0x2A  // PIP Window Display Upper-Left X coordinate 0
+#define RA8876_REG_PWDULX1 0x2B  // PIP Window Display Upper-Left X coordinate 1
+#define RA8876_REG_PWDULY0 0x2C  // PIP Window Display Upper-Left Y coordinate 0
+#define RA8876_REG_PWDULY1 0x2D  // PIP Window Display Upper-Left Y coordinate 1
+#define RA8876_REG_PISA0   0x2E  // PIP Image Start Address 0
+#define RA8876_REG_PISA1   0x2F  // PIP Image Start Address 1
+#define RA8876_REG_PISA2   0x30  // PIP Image Start Address 2
+#define RA8876_REG_PISA3   0x31  // PIP Image Start Address 3
+#define RA8876_REG_PIW0    0x32  // PIP Image Width 0
+#define RA8876_REG_PIW1    0x33  // PIP Image Width 1
+#define RA8876_REG_PWIULX0 0x34  // PIP Window Image Upper-Left X coordinate 0
+#define RA8876_REG_PWIULX1 0x35  // PIP Window Image Upper-Left X coordinate 1
+#define RA8876_REG_PWIULY0 0x36  // PIP Window Image Upper-Left Y coordinate 0
+#define RA8876_REG_PWIULY1 0x37  // PIP Window Image Upper-Left Y coordinate 1
+#define RA8876_REG_PWW0    0x38  // PIP Window Width 0
+#define RA8876_REG_PWW1    0x39  // PIP Window Width 1
+#define RA8876_REG_PWH0    0x3A  // PIP Window Height 0
+#define RA8876_REG_PWH1    0x3B  // PIP Window Height 1
 
 // Data sheet 19.6: Geometric engine control registers
 #define RA8876_REG_CVSSA0     0x50  // Canvas Start Address 0
@@ -243,6 +299,59 @@ typedef uint8_t FontFlags;
 #define RA8876_REG_PMUXR      0x85  // PWM clock mux register
 #define RA8876_REG_PCFGR      0x86  // PWM configuration register
 
+// Data sheet 19.8: Block Transfer Engine (BTE) control registers
+#define RA8876_REG_BTE_CTRL0  0x90  // BTE function control register 0
+#define RA8876_REG_BTE_CTRL1  0x91  // BTE function control register 1
+#define RA8876_REG_BTE_COLR   0x92  // Source 0/1 & destination color depth
+#define RA8876_REG_S0_STR0    0x93  // Source 0 memory start address 0
+#define RA8876_REG_S0_STR1    0x94  // Source 0 memory start address 1
+#define RA8876_REG_S0_STR2    0x95  // Source 0 memory start address 2
+#define RA8876_REG_S0_STR3    0x96  // Source 0 memory start address 3
+#define RA8876_REG_S0_WTH0    0x97  // Source 0 image width 0
+#define RA8876_REG_S0_WTH1    0x98  // Source 0 image width 1
+#define RA8876_REG_S0_X0      0x99  // Source 0 window upper-left X coordinate 0
+#define RA8876_REG_S0_X1      0x9A  // Source 0 window upper-left X coordinate 1
+#define RA8876_REG_S0_Y0      0x9B  // Source 0 window upper-left Y coordinate 0
+#define RA8876_REG_S0_Y1      0x9C  // Source 0 window upper-left Y coordinate 1
+#define RA8876_REG_S1_STR0    0x9D  // Source 1 memory start address 0
+#define RA8876_REG_S1_STR1    0x9E  // Source 1 memory start address 1
+#define RA8876_REG_S1_STR2    0x9F  // Source 1 memory start address 2
+#define RA8876_REG_S1_STR3    0xA0  // Source 1 memory start address 3
+#define RA8876_REG_S1_WTH0    0xA1  // Source 1 image width 0
+#define RA8876_REG_S1_WTH1    0xA2  // Source 1 image width 1
+#define RA8876_REG_S1_X0      0xA3  // Source 1 window upper-left X coordinate 0
+#define RA8876_REG_S1_X1      0xA4  // Source 1 window upper-left X coordinate 1
+#define RA8876_REG_S1_Y0      0xA5  // Source 1 window upper-left Y coordinate 0
+#define RA8876_REG_S1_Y1      0xA6  // Source 1 window upper-left Y coordinate 1
+#define RA8876_REG_DT_STR0    0xA7  // Destination memory start address 0
+#define RA8876_REG_DT_STR1    0xA8  // Destination memory start address 1
+#define RA8876_REG_DT_STR2    0xA9  // Destination memory start address 2
+#define RA8876_REG_DT_STR3    0xAA  // Destination memory start address 3
+#define RA8876_REG_DT_WTH0    0xAB  // Destination image width 0
+#define RA8876_REG_DT_WTH1    0xAC  // Destination image width 1
+#define RA8876_REG_DT_X0      0xAD  // Destination window upper-left X coordinate 0
+#define RA8876_REG_DT_X1      0xAE  // Destination window upper-left X coordinate 1
+#define RA8876_REG_DT_Y0      0xAF  // Destination window upper-left Y coordinate 0
+#define RA8876_REG_DT_Y1      0xB0  // Destination window upper-left Y coordinate 1
+#define RA8876_REG_BTE_WTH0   0xB1  // BTE window width 0
+#define RA8876_REG_BTE_WTH1   0xB2  // BTE window width 1
+#define RA8876_REG_BTE_HIG0   0xB3  // BTE window height 0
+#define RA8876_REG_BTE_HIG1   0xB4  // BTE window height 1
+#define RA8876_REG_APB_CTRL   0xB5  // Alpha blending
+
+// BTE operation codes (BTE_CTRL1 bits 3..0)
+#define RA8876_BTE_MPU_WRITE_ROP             0x0
+#define RA8876_BTE_MEMORY_COPY_ROP           0x2
+#define RA8876_BTE_MPU_WRITE_CHROMA          0x4
+#define RA8876_BTE_MEMORY_COPY_CHROMA        0x5
+#define RA8876_BTE_MPU_WRITE_EXPAND          0x8
+#define RA8876_BTE_MPU_WRITE_EXPAND_CHROMA   0x9
+#define RA8876_BTE_MEMORY_COPY_OPACITY       0xA
+#define RA8876_BTE_MPU_WRITE_OPACITY         0xB
+#define RA8876_BTE_SOLID_FILL                0xC
+#define RA8876_BTE_MEMORY_COPY_EXPAND        0xE
+#define RA8876_BTE_MEMORY_COPY_EXPAND_CHROMA 0xF
+
 // Data sheet 19.9: Serial flash & SPI master control registers
 #define RA8876_REG_SFL_CTRL   0xB7  // Serial flash/ROM control register
 #define RA8876_REG_SPI_DIVSOR 0xBB  // SPI clock period
@@ -258,6 +367,13 @@ typedef uint8_t FontFlags;
 #define RA8876_REG_FGCR       0xD2  // Foreground colour register - red
 #define RA8876_REG_FGCG       0xD3  // Foreground colour register - green
 #define RA8876_REG_FGCB       0xD4  // Foreground colour register - blue
+#define RA8876_REG_BGCR       0xD5  // Background colour register - red
+#define RA8876_REG_BGCG       0xD6  // Background colour register - green
+#define RA8876_REG_BGCB       0xD7  // Background colour register - blue
+#define RA8876_REG_CGRAM_STR0 0xDB  // CGRAM start address 0
+#define RA8876_REG_CGRAM_STR1 0xDC  // CGRAM start address 1
+#define RA8876_REG_CGRAM_STR2 0xDD  // CGRAM start address 2
+#define RA8876_REG_CGRAM_STR3 0xDE  // CGRAM start address 3
 
 // Data sheet 19.12: SDRAM control registers
 #define RA8876_REG_SDRAR         0xE0  // SDRAM attribute register
@@ -270,12 +386,15 @@ typedef uint8_t FontFlags;
 class RA8876 : public Print
 {
 private:
-  int m_csPin;
+  RA8876SpiTransport m_spiTransport;  // Used when constructed with a chip select pin
+  RA8876Transport   *m_transport;
+
   int m_resetPin;
 
   int m_width;
   int m_height;
-  int m_depth;
+  int m_depth;         // Display (main window) colour depth
+  int m_canvasDepth;
 
   uint32_t m_oscClock;   // OSC clock (external crystal) frequency in kHz
 
@@ -283,38 +402,126 @@ private:
   PllParams m_corePll;  // CCLK (core) PLL parameters
   PllParams m_scanPll;  // SCLK (LCD panel scan) PLL parameters
 
-  SPISettings m_spiSettings;
-
   SdramInfo *m_sdramInfo;
 
+  RA8876SdramAllocator m_sdram;
+
   DisplayInfo *m_displayInfo;
 
   ExternalFontRomInfo m_fontRomInfo;
 
+  // Shadow copies of configuration registers that only the driver modifies, so that
+  //  read-modify-write updates don't need to read from the chip.
+  uint8_t m_ccr;
+  uint8_t m_icr;
+  uint8_t m_dpcr;
+  uint8_t m_mpwctr;
+  uint8_t m_pipcdep;
+  uint8_t m_awColor;
+  uint8_t m_ccr1;
+
+  // Last values written to the geometry engine registers (DLHSR0..DEVR1) followed by
+  //  the foreground colour registers (FGCR..FGCB), so unchanged values can be skipped.
+  uint8_t  m_regCache[(RA8876_REG_DEVR1 - RA8876_REG_DLHSR0 + 1) + 3];
+  uint32_t m_regCacheValid;  // Bit n set if m_regCache[n] is known to match the chip
+
   uint16_t m_textColor;
   int      m_textScaleX;
   int      m_textScaleY;
 
+  // Canvas image, as last set by setCanvasRegion() (width 0 for linear addressing)
+  uint32_t m_canvasAddress;
+  uint16_t m_canvasWidth;
+
+  // Active window within the canvas, as last set by setCanvasWindow()
+  uint16_t m_windowX;
+  uint16_t m_windowY;
+  uint16_t m_windowWidth;
+  uint16_t m_windowHeight;
+
+  // Page flipping
+  int      m_pageCount;    // 0 if not in use
+  uint32_t m_pageAddress[RA8876_MAX_PAGES];
+  int      m_frontPage;    // Page being displayed
+  int      m_backPage;     // Page being drawn
+  int      m_pendingPage;  // Page to be displayed at the next VSYNC, or -1
+  unsigned long m_flipPolled;  // micros() when the VSYNC flag was last seen clear
+
+  RA8876DirtyTracker *m_dirty;  // Receives the area of each drawing operation, if set
+
+  bool m_asyncDraw;    // Shape drawing returns without waiting for the engine
+  bool m_taskPending;  // A shape may still be drawing
+  bool m_pushActive;   // Between beginPushAsync() and endPushAsync()
+
+  int m_fifoFree;      // Write FIFO entries known to be free, during text output
+
+  // Software copy of the text cursor, kept in step with text output
+  int  m_cursorX;
+  int  m_cursorY;
+  bool m_cursorKnown;  // False when it must be read back from the chip
+  bool m_cursorStale;  // The chip's cursor lags behind text drawn from the glyph cache
+
   enum FontSource m_fontSource;
   enum FontSize   m_fontSize;
   FontFlags       m_fontFlags;
+  enum ExternalFontFamily m_fontFamily;
+  enum FontEncoding       m_fontEncoding;
+
+  RA8876Utf8Decoder      m_utf8;            // Carries sequences split between write() calls
+  const UnicodeMapEntry *m_unicodeMap;      // PROGMEM, or 0 if none
+  size_t                 m_unicodeMapSize;
+
+  // User-defined font
+  uint32_t      m_cgramAddress;    // RA8876_SDRAM_NONE if none
+  enum FontSize m_cgramSize;
+  unsigned int  m_cgramCount;
+  bool          m_cgramFullWidth;
+
+  // Font ROM glyph cache: one-bit-per-pixel bitmaps in m_glyphBitmaps, packed into
+  //  units of the canvas depth, and a cell to render each new glyph in
+  RA8876GlyphCache *m_glyphCache;  // 0 if none
+  SdramSurface      m_glyphBitmaps;
+  SdramSurface      m_glyphScratch;
+  int               m_glyphLead;   // First byte of a two-byte code split between writes, or -1
+
+  // Bitmap font
+  struct GlyphDraw
+  {
+    int16_t  x;       // Canvas position of the bitmap's top left
+    int16_t  y;
+    uint8_t  width;
+    uint8_t  height;
+    const RA8876FontAtlas::Placement *placement;
+  };
+
+  const RA8876FontAtlas *m_bitmapFont;
+  uint32_t               m_bitmapBackground;  // 0xRRGGBB, for anti-aliasing
+  uint32_t               m_kernLeft;          // Character before the cursor, or 0
+
+  void initState(void);
 
   void hardReset(void);
   void softReset(void);
 
-  void writeCmd(uint8_t x);
-  void writeData(uint8_t x);
-  uint8_t readData(void);
-  uint8_t readStatus(void);
+  inline void writeCmd(uint8_t x) { m_transport->writeCmd(x); };
+  inline void writeData(uint8_t x) { m_transport->writeData(x); };
+  inline uint8_t readData(void) { return m_transport->readData(); };
+  inline uint8_t readStatus(void) { return m_transport->readStatus(); };
 
   void writeReg(uint8_t reg, uint8_t x);
   void writeReg16(uint8_t reg, uint16_t x);
   void writeReg32(uint8_t reg, uint32_t x);
   uint8_t readReg(uint8_t reg);
   uint16_t readReg16(uint8_t reg);
+  uint8_t readShadowReg(uint8_t reg, uint8_t *shadow);
+  void writeShadowReg(uint8_t reg, uint8_t *shadow, uint8_t v);
+  void writeCachedReg(uint8_t reg, uint8_t v);
+  void writeCachedReg16(uint8_t reg, uint16_t v);
 
   inline void waitWriteFifo(void) { while (readStatus() & 0x80); };
   inline void waitTaskBusy(void) { while (readStatus() & 0x08); };
+  inline void waitWriteFifoEmpty(void) { while (!(readStatus() & 0x40)); };
+  void waitPendingTask(void);
 
   bool calcPllParams(uint32_t targetFreq, int kMax, PllParams *pll);
   bool calcClocks(void);
@@ -324,6 +531,11 @@ private:
   bool initMemory(SdramInfo *info);
   bool initDisplay(void);
 
+  // Depth field value used by MPWCTR, AW_COLOR, PIPCDEP and BTE_COLR
+  uint8_t depthBits(int depth) { return (depth == 8) ? 0x00 : ((depth == 16) ? 0x01 : 0x02); };
+
+  uint32_t frameSize(void) { return (uint32_t) m_width * m_height * (m_depth / 8); };
+
   // Font utils
   uint8_t internalFontEncoding(enum FontEncoding enc);
 
@@ -331,24 +543,100 @@ private:
   void setTextMode(void);
   void setGraphicsMode(void);
 
+  // Canvas helpers
+  void writeActiveWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+  void markDirty(int x1, int y1, int x2, int y2);
+  void markTextDirty(int x, int y);
+
+  // Text helpers
+  void writeText(const uint8_t *buffer, size_t size);
+  void writeTextData(uint8_t x);
+  void syncCursor(void);
+  void advanceCursor(void);
+  int halfWidth(uint8_t c);
+  int charWidth(const uint8_t *str, size_t len, size_t *pos);
+  uint16_t fontCode(uint32_t c);
+  bool loadUserChars(uint16_t code, unsigned int count, const uint8_t *bitmaps, bool progmem);
+
+  // Glyph cache helpers
+  bool useGlyphCache(void);
+  int cacheGlyph(uint16_t code, bool wide);
+  void drawCachedGlyph(int slot, int x, int y);
+  void writeCachedText(const uint8_t *buffer, size_t size);
+
+  // Bitmap font helpers
+  void writeGlyphPlanes(const RA8876Font *font, const RA8876Glyph *g, const RA8876FontAtlas::Placement *p);
+  void drawBitmapGlyphs(const GlyphDraw *run, int count);
+  void writeBitmapText(const uint8_t *buffer, size_t size);
+
+  // Memory writes
+  void writeMemory(const uint8_t *pixels, int srcBytes, unsigned int count, bool progmem);
+  void pushPixels(int x, int y, int width, int height, const uint8_t *pixels, int srcBytes, int stride, bool progmem);
+
+  // Page flipping
+  void setCanvasPage(int page);
+
+  // PIP windows
+  bool selectPip(int pip);
+
   // Low-level shapes
+  void setForegroundColor(uint16_t color);
+  void setForegroundRgb(uint32_t rgb);
   void drawTwoPointShape(int x1, int y1, int x2, int y2, uint16_t color, uint8_t reg, uint8_t cmd);  // drawLine, drawRect, fillRect
   void drawThreePointShape(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color, uint8_t reg, uint8_t cmd);  // drawTriangle, fillTriangle
   void drawEllipseShape(int x, int y, int xrad, int yrad, uint16_t color, uint8_t cmd);  // drawCircle, fillCircle
+
+  // Block transfers
+  uint8_t bteColorDepth(void);
+  void setKeyColor(uint16_t color);
+  void bteStart(uint8_t ctrl1, uint32_t s0Addr, uint16_t s0Width, int s0x, int s0y,
+                uint32_t dtAddr, uint16_t dtWidth, int dtx, int dty, int width, int height);
+  bool bteCopyRect(uint8_t ctrl1, uint32_t srcAddr, uint16_t srcWidth, int sx, int sy,
+                   uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height);
+  void beginExpand(const SdramSurface *source);
+  void bteExpand(int sx, int sy, int x, int y, int width, int height);
 public:
   RA8876(int csPin, int resetPin = 0);
+  RA8876(RA8876Transport *transport, int resetPin = -1);
 
   // Init
-  bool init(void);
+  bool init(int depth = 16);
   void initExternalFontRom(int spiIf, enum ExternalFontRom chip);
 
   // Canvas region
   bool setCanvasRegion(uint32_t address, uint16_t width = 0);
   bool setCanvasWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+  void getCanvasWindow(uint16_t *x, uint16_t *y, uint16_t *width, uint16_t *height) { *x = m_windowX; *y = m_windowY; *width = m_windowWidth; *height = m_windowHeight; };
+  bool setCanvasDepth(int depth);
 
   // Display region
   bool setDisplayRegion(uint32_t address, uint16_t width);
   bool setDisplayOffset(uint16_t x, uint16_t y);
+  bool setDisplayDepth(int depth);
+
+  // SDRAM allocation
+  uint32_t getSdramSize(void);
+  uint32_t getSdramFree(void) { return m_sdram.freeBytes(); };
+  bool allocSurface(uint16_t width, uint16_t height, SdramSurface *surface, int depth = 0);
+  void freeSurface(SdramSurface *surface);
+
+  // PIP windows
+  bool setPipWindow(int pip, uint32_t address, uint16_t imageWidth, int depth, uint16_t imageX, uint16_t imageY, uint16_t width, uint16_t height);
+  bool setPipWindow(int pip, const SdramSurface *surface) { return setPipWindow(pip, surface->address, surface->width, surface->depth, 0, 0, surface->width, surface->height); };
+  bool movePip(int pip, uint16_t x, uint16_t y);
+  bool scrollPip(int pip, uint16_t imageX, uint16_t imageY);
+  void enablePip(int pip, bool enabled);
+
+  // Page flipping
+  bool initPages(int count);
+  uint32_t getPageAddress(int page) { return m_pageAddress[page]; };
+  int getFrontPage(void) { return m_frontPage; };
+  int getBackPage(void) { return m_backPage; };
+  bool requestFlip(void);  // With two pages, draw nothing until updateFlip() returns true
+  bool updateFlip(bool wait = false);  // Never blocks unless wait is set
+  bool isFlipPending(void) { return m_pendingPage >= 0; };
+  void flip(void);
+  uint32_t blankingMicros(void);
 
   // Dimensions
   int getWidth() { return m_width; };
@@ -357,8 +645,29 @@ public:
   // Test
   void colorBarTest(bool enabled);
 
+  // Damage tracking
+  void setDirtyTracker(RA8876DirtyTracker *tracker) { m_dirty = tracker; };
+  void copyDirty(uint32_t srcAddr, uint32_t dstAddr, uint16_t width);
+
+  // Asynchronous drawing
+  void setAsyncDrawing(bool enabled);
+  bool isBusy(void);
+  void waitIdle(void);
+
   // Drawing
   void drawPixel(int x, int y, uint16_t color);
+  void pushPixels(int x, int y, int width, int height, const uint16_t *pixels, int stride = 0) { pushPixels(x, y, width, height, (const uint8_t *) pixels, 2, stride, false); };
+  void pushPixels_P(int x, int y, int width, int height, const uint16_t *pixels, int stride = 0) { pushPixels(x, y, width, height, (const uint8_t *) pixels, 2, stride, true); };  // Pixels in PROGMEM
+  void pushPixels8(int x, int y, int width, int height, const uint8_t *pixels, int stride = 0) { pushPixels(x, y, width, height, pixels, 1, stride, false); };  // RGB332
+  void pushPixels24(int x, int y, int width, int height, const uint8_t *pixels, int stride = 0) { pushPixels(x, y, width, height, pixels, 3, stride, false); };  // RGB888, red first
+  void drawBitmap(int x, int y, int width, int height, const uint16_t *bitmap) { pushPixels(x, y, width, height, bitmap); };
+
+  // Background pixel streaming
+  bool beginPushAsync(int x, int y, int width, int height);
+  void pushAsync(const uint16_t *pixels, unsigned int count, RA8876TransferCallback callback = 0, void *context = 0);
+  bool isPushBusy(void);
+  void endPushAsync(void);
+
   void drawLine(int x1, int y1, int x2, int y2, uint16_t color) { drawTwoPointShape(x1, y1, x2, y2, color, RA8876_REG_DCR0, 0x80); };
   void drawRect(int x1, int y1, int x2, int y2, uint16_t color) { drawTwoPointShape(x1, y1, x2, y2, color, RA8876_REG_DCR1, 0xA0); };
   void fillRect(int x1, int y1, int x2, int y2, uint16_t color) { drawTwoPointShape(x1, y1, x2, y2, color, RA8876_REG_DCR1, 0xE0); };
@@ -369,6 +678,12 @@ public:
   void drawCircle(int x, int y, int radius, uint16_t color) { drawEllipseShape(x, y, radius, radius, color, 0x80); };
   void fillCircle(int x, int y, int radius, uint16_t color) { drawEllipseShape(x, y, radius, radius, color, 0xC0); };
 
+  // Block transfers between SDRAM regions (block addressing, widths in pixels)
+  bool bteCopy(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height, enum BteRop rop = RA8876_ROP_S0);
+  bool bteCopyTransparent(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, uint32_t dstAddr, uint16_t dstWidth, int dx, int dy, int width, int height, uint16_t keyColor);
+  bool drawSprite(uint32_t srcAddr, uint16_t srcWidth, int sx, int sy, int x, int y, int width, int height, uint16_t keyColor);
+  bool scrollRect(int x, int y, int width, int height, int dy, uint16_t fill);
+
   void clearScreen(uint16_t color) { setCursor(0, 0); fillRect(0, 0, m_width, m_height, color); };
 
   // Text cursor
@@ -379,14 +694,35 @@ public:
   // Text
   void selectInternalFont(enum FontSize size, enum FontEncoding enc = RA8876_FONT_ENCODING_8859_1);
   void selectExternalFont(enum ExternalFontFamily family, enum FontSize size, enum FontEncoding enc, FontFlags flags = 0);
+  bool initUserFont(enum FontSize size, unsigned int count, bool fullWidth = false);
+  bool loadUserChars(uint16_t code, unsigned int count, const uint8_t *bitmaps) { return loadUserChars(code, count, bitmaps, false); };
+  bool loadUserChars_P(uint16_t code, unsigned int count, const uint8_t *bitmaps) { return loadUserChars(code, count, bitmaps, true); };  // Bitmaps in PROGMEM
+  void selectUserFont(void);
   int getTextSizeY(void);
   void setTextColor(uint16_t color) { m_textColor = color; };
+  uint16_t getTextColor(void) { return m_textColor; };
   void setTextScale(int scale) { setTextScale(scale, scale); };
   void setTextScale(int xScale, int yScale);
   void putChar(char c) { putChars(&c, 1); };
   void putChars(const char *buffer, size_t size);
   void putChar16(uint16_t c) { putChars16(&c, 1); };
   void putChars16(const uint16_t *buffer, unsigned int count);
+  void setUnicodeMap(const UnicodeMapEntry *map, size_t count) { m_unicodeMap = map; m_unicodeMapSize = count; };  // For RA8876_FONT_FLAG_UTF8
+  bool setGlyphCache(RA8876GlyphCache *cache);  // For external font ROM text; 0 to stop caching
+  bool loadFont(const RA8876Font *font, RA8876FontAtlas *atlas);
+  void freeFont(RA8876FontAtlas *atlas);
+  void selectBitmapFont(const RA8876FontAtlas *atlas, uint16_t background = 0x0000);  // Text is UTF-8
+
+  // Text measurement and layout, from font metrics without bus traffic
+  int measureText(const char *str) { return measureText(str, strlen(str)); };
+  int measureText(const char *str, size_t len);
+  int measureText16(const uint16_t *str, unsigned int count);
+  size_t fitText(const char *str, size_t len, int width, size_t *next);
+  int alignText(const char *str, size_t len, int width, enum TextAlign align);
+  int printWrapped(int x, int y, int width, const char *str, enum TextAlign align = RA8876_ALIGN_LEFT);
+
+  // Display lists
+  void drawList(RA8876DisplayList *list);
 
   // Internal for Print class
   virtual size_t write(uint8_t c) { return write(&c, 1); };
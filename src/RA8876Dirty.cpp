@@ -0,0 +1,96 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Dirty.h"
+
+static uint32_t rectArea(const DirtyRect *r)
+{
+  return (uint32_t) (r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1);
+}
+
+static void rectUnion(const DirtyRect *a, const DirtyRect *b, DirtyRect *u)
+{
+  u->x1 = min(a->x1, b->x1);
+  u->y1 = min(a->y1, b->y1);
+  u->x2 = max(a->x2, b->x2);
+  u->y2 = max(a->y2, b->y2);
+}
+
+// Pixels shared by two rectangles.
+static uint32_t overlapArea(const DirtyRect *a, const DirtyRect *b)
+{
+  int w = min(a->x2, b->x2) - max(a->x1, b->x1) + 1;
+  int h = min(a->y2, b->y2) - max(a->y1, b->y1) + 1;
+
+  return ((w > 0) && (h > 0)) ? (uint32_t) w * h : 0;
+}
+
+void RA8876DirtyTracker::removeRect(int i)
+{
+  m_rects[i] = m_rects[--m_count];
+}
+
+void RA8876DirtyTracker::add(int x1, int y1, int x2, int y2)
+{
+  DirtyRect r;
+  r.x1 = min(x1, x2);
+  r.y1 = min(y1, y2);
+  r.x2 = max(x1, x2);
+  r.y2 = max(y1, y2);
+
+  // Absorb every rectangle whose union with this one wastes little. Each merge removes
+  //  one, so this ends after at most m_count passes.
+  bool merged;
+  do
+  {
+    merged = false;
+    for (int i = 0; i < m_count; i++)
+    {
+      DirtyRect u;
+      rectUnion(&r, &m_rects[i], &u);
+
+      uint32_t covered = rectArea(&r) + rectArea(&m_rects[i]) - overlapArea(&r, &m_rects[i]);
+      if (rectArea(&u) - covered <= RA8876_DIRTY_MERGE_WASTE)
+      {
+        r = u;
+        removeRect(i);
+        merged = true;
+        break;
+      }
+    }
+  } while (merged);
+
+  if (m_count < RA8876_MAX_DIRTY_RECTS)
+  {
+    m_rects[m_count++] = r;
+    return;
+  }
+
+  // Full: merge into the rectangle that grows least, then let the result absorb others
+  int best = 0;
+  uint32_t bestGrowth = 0xFFFFFFFF;
+  for (int i = 0; i < m_count; i++)
+  {
+    DirtyRect u;
+    rectUnion(&r, &m_rects[i], &u);
+
+    uint32_t growth = rectArea(&u) - rectArea(&m_rects[i]);
+    if (growth < bestGrowth)
+    {
+      best = i;
+      bestGrowth = growth;
+    }
+  }
+
+  DirtyRect u;
+  rectUnion(&r, &m_rects[best], &u);
+  removeRect(best);
+  add(u.x1, u.y1, u.x2, u.y2);
+}
+
+uint32_t RA8876DirtyTracker::area(void) const
+{
+  uint32_t total = 0;
+  for (int i = 0; i < m_count; i++)
+    total += rectArea(&m_rects[i]);
+
+  return total;
+}
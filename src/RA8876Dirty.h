@@ -0,0 +1,50 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_DIRTY_H
+#define RA8876_DIRTY_H
+
+#include <Arduino.h>
+
+// Maximum number of separate rectangles kept by a dirty tracker.
+#define RA8876_MAX_DIRTY_RECTS 16
+
+// Pixels that merging two rectangles may add beyond those they cover. Copying a few
+//  clean pixels costs less than the register writes that set up another copy.
+#ifndef RA8876_DIRTY_MERGE_WASTE
+#define RA8876_DIRTY_MERGE_WASTE 1024
+#endif
+
+// Inclusive corners, as for fillRect().
+struct DirtyRect
+{
+  int16_t x1;
+  int16_t y1;
+  int16_t x2;
+  int16_t y2;
+};
+
+// Accumulates the areas touched by drawing, for partial updates. Rectangles are merged
+//  when their union covers no more than RA8876_DIRTY_MERGE_WASTE pixels that neither
+//  does, so nearby and partly overlapping updates share one copy. The table is fixed in size: when it is full, a new rectangle is merged
+//  into whichever existing one grows least, so adding stays cheap however many
+//  updates a frame has.
+class RA8876DirtyTracker
+{
+private:
+  DirtyRect m_rects[RA8876_MAX_DIRTY_RECTS];
+  int       m_count;
+
+  void removeRect(int i);
+
+public:
+  RA8876DirtyTracker() { m_count = 0; };
+
+  void add(int x1, int y1, int x2, int y2);
+  void clear(void) { m_count = 0; };
+
+  int count(void) const { return m_count; };
+  const DirtyRect *rect(int i) const { return &m_rects[i]; };
+  uint32_t area(void) const;
+};
+
+#endif
@@ -0,0 +1,260 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876DisplayList.h"
+
+void RA8876DisplayList::reset(void)
+{
+  m_count    = 0;
+  m_textLen  = 0;
+  m_overflow = false;
+
+  m_textColor = 0xFFFF;  // White, as on the RA8876
+  m_cursorX   = RA8876_DL_CONTINUE;
+  m_cursorY   = RA8876_DL_CONTINUE;
+  m_textOpen  = false;
+
+  m_planned = false;
+}
+
+DisplayOp *RA8876DisplayList::addOp(uint8_t type, uint16_t color)
+{
+  if (m_count == RA8876_DISPLAY_LIST_OPS)
+  {
+    m_overflow = true;
+    return 0;
+  }
+
+  m_planned = false;
+
+  DisplayOp *op = &m_ops[m_count++];
+  op->type  = type;
+  op->color = color;
+
+  return op;
+}
+
+void RA8876DisplayList::addShape(uint8_t type, int x1, int y1, int x2, int y2, uint16_t color)
+{
+  DisplayOp *op = addOp(type, color);
+  if (!op)
+    return;
+
+  op->x1 = x1;
+  op->y1 = y1;
+  op->x2 = x2;
+  op->y2 = y2;
+
+  m_textOpen = false;
+}
+
+void RA8876DisplayList::clearScreen(uint16_t color)
+{
+  addShape(RA8876_OP_CLEAR, 0, 0, 0, 0, color);
+
+  // The RA8876 homes the cursor too
+  m_cursorX = 0;
+  m_cursorY = 0;
+}
+
+size_t RA8876DisplayList::write(const uint8_t *buffer, size_t size)
+{
+  if (m_textLen + size > RA8876_DISPLAY_LIST_TEXT)
+  {
+    m_overflow = true;
+    return 0;
+  }
+
+  if (!m_textOpen)
+  {
+    DisplayOp *op = addOp(RA8876_OP_TEXT, m_textColor);
+    if (!op)
+      return 0;
+
+    op->x1 = m_cursorX;
+    op->y1 = m_cursorY;
+    op->x2 = m_textLen;
+    op->y2 = 0;
+
+    m_cursorX  = RA8876_DL_CONTINUE;
+    m_cursorY  = RA8876_DL_CONTINUE;
+    m_textOpen = true;
+  }
+
+  memcpy(&m_text[m_textLen], buffer, size);
+  m_textLen += size;
+  m_ops[m_count - 1].y2 += size;
+  m_planned = false;
+
+  return size;
+}
+
+// Finds the area of the canvas window an operation may touch. For text this is an upper
+//  bound: each character is taken to be as wide as the widest, and text that might wrap
+//  or that starts from an unknown position is taken to reach the edges of the window.
+void RA8876DisplayList::bounds(int i, int advance, int lineHeight, int overhang, const DirtyRect *window, DirtyRect *r) const
+{
+  const DisplayOp *op = &m_ops[i];
+  long x1, y1, x2, y2;
+
+  switch (op->type)
+  {
+  case RA8876_OP_LINE:
+  case RA8876_OP_RECT:
+  case RA8876_OP_FILL_RECT:
+    x1 = min(op->x1, op->x2);
+    y1 = min(op->y1, op->y2);
+    x2 = max(op->x1, op->x2);
+    y2 = max(op->y1, op->y2);
+    break;
+  case RA8876_OP_CIRCLE:
+  case RA8876_OP_FILL_CIRCLE:
+    x1 = op->x1 - op->x2;
+    y1 = op->y1 - op->x2;
+    x2 = op->x1 + op->x2;
+    y2 = op->y1 + op->x2;
+    break;
+  case RA8876_OP_TEXT:
+    if (op->x1 != RA8876_DL_CONTINUE)
+    {
+      // Every character takes at least one byte, so the length in bytes will do
+      bool newline = memchr(&m_text[op->x2], '\n', op->y2) != 0;
+      long right = op->x1 + (long) op->y2 * advance - 1;
+
+      y1 = op->y1 - overhang;
+      if (!newline && (right <= window->x2))
+      {
+        x1 = op->x1 - overhang;
+        x2 = right + overhang;
+        y2 = op->y1 + lineHeight - 1 + overhang;
+      }
+      else
+      {
+        x1 = window->x1;
+        x2 = window->x2;
+        y2 = window->y2;
+      }
+      break;
+    }
+    // Fall through
+  default:
+    x1 = window->x1;
+    y1 = window->y1;
+    x2 = window->x2;
+    y2 = window->y2;
+    break;
+  }
+
+  // Nothing is drawn outside the canvas window
+  r->x1 = max(x1, (long) window->x1);
+  r->y1 = max(y1, (long) window->y1);
+  r->x2 = min(x2, (long) window->x2);
+  r->y2 = min(y2, (long) window->y2);
+}
+
+static bool rectContains(const DirtyRect *outer, const DirtyRect *inner)
+{
+  return (outer->x1 <= inner->x1) && (outer->y1 <= inner->y1) && (outer->x2 >= inner->x2) && (outer->y2 >= inner->y2);
+}
+
+static bool rectsOverlap(const DirtyRect *a, const DirtyRect *b)
+{
+  return (a->x1 <= b->x2) && (b->x1 <= a->x2) && (a->y1 <= b->y2) && (b->y1 <= a->y2);
+}
+
+// Works out the replay order for the given text metrics and window, unless that was
+//  already done for the list as it stands.
+int RA8876DisplayList::plan(int advance, int lineHeight, int overhang, const DirtyRect *window)
+{
+  if (m_planned && (m_planText[0] == advance) && (m_planText[1] == lineHeight) && (m_planText[2] == overhang) &&
+      !memcmp(&m_planWindow, window, sizeof(DirtyRect)))
+    return m_orderLen;
+
+  DirtyRect rects[RA8876_DISPLAY_LIST_OPS];
+  bool      done[RA8876_DISPLAY_LIST_OPS];
+
+  for (int i = 0; i < m_count; i++)
+    bounds(i, advance, lineHeight, overhang, window, &rects[i]);
+
+  // Drop operations painted over by a later opaque fill. Text that the next surviving
+  //  text carries on from has to stay, to leave the cursor where that expects it.
+  bool continued = false;
+  int  kept = 0;
+  for (int i = m_count - 1; i >= 0; i--)
+  {
+    const DisplayOp *op = &m_ops[i];
+
+    done[i] = false;
+    if (!((op->type == RA8876_OP_TEXT) && continued))
+    {
+      for (int j = i + 1; j < m_count; j++)
+      {
+        uint8_t type = m_ops[j].type;
+        if (((type == RA8876_OP_FILL_RECT) || (type == RA8876_OP_CLEAR)) && rectContains(&rects[j], &rects[i]))
+        {
+          done[i] = true;
+          break;
+        }
+      }
+    }
+
+    if (done[i])
+      continue;
+
+    kept++;
+    if (op->type == RA8876_OP_TEXT)
+      continued = (op->x1 == RA8876_DL_CONTINUE);
+  }
+
+  // Pick operations one at a time, preferring to stay in the same mode and then the
+  //  same colour. An operation is ready once everything before it that it overlaps has
+  //  been picked.
+  bool    textMode = false;
+  int32_t color = -1;
+  m_orderLen = 0;
+  while (m_orderLen < kept)
+  {
+    int best = -1;
+    int bestScore = -1;
+
+    for (int j = 0; (j < m_count) && (bestScore < 3); j++)
+    {
+      if (done[j])
+        continue;
+
+      bool text = (m_ops[j].type == RA8876_OP_TEXT);
+
+      bool ready = true;
+      for (int i = 0; (i < j) && ready; i++)
+      {
+        if (done[i])
+          continue;
+
+        if ((text && (m_ops[i].type == RA8876_OP_TEXT)) || rectsOverlap(&rects[i], &rects[j]))
+          ready = false;
+      }
+
+      if (!ready)
+        continue;
+
+      int score = ((text == textMode) ? 2 : 0) + ((m_ops[j].color == color) ? 1 : 0);
+      if (score > bestScore)
+      {
+        best = j;
+        bestScore = score;
+      }
+    }
+
+    done[best] = true;
+    m_order[m_orderLen++] = best;
+
+    textMode = (m_ops[best].type == RA8876_OP_TEXT);
+    color    = m_ops[best].color;
+  }
+
+  m_planned = true;
+  m_planText[0] = advance;
+  m_planText[1] = lineHeight;
+  m_planText[2] = overhang;
+  m_planWindow  = *window;
+
+  return m_orderLen;
+}
@@ -0,0 +1,110 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_DISPLAY_LIST_H
+#define RA8876_DISPLAY_LIST_H
+
+#include <Arduino.h>
+
+#include "RA8876Dirty.h"
+
+// Capacity of a display list: operations, and bytes of text shared between them.
+#ifndef RA8876_DISPLAY_LIST_OPS
+#define RA8876_DISPLAY_LIST_OPS 48
+#endif
+#ifndef RA8876_DISPLAY_LIST_TEXT
+#define RA8876_DISPLAY_LIST_TEXT 256
+#endif
+
+// Text position meaning "wherever the previous text left the cursor".
+#define RA8876_DL_CONTINUE (-32768)
+
+enum DisplayOpType
+{
+  RA8876_OP_LINE,
+  RA8876_OP_RECT,
+  RA8876_OP_FILL_RECT,
+  RA8876_OP_CIRCLE,
+  RA8876_OP_FILL_CIRCLE,
+  RA8876_OP_CLEAR,
+  RA8876_OP_TEXT
+};
+
+struct DisplayOp
+{
+  uint8_t  type;   // DisplayOpType
+  uint16_t color;
+  // Lines and rectangles: corners. Circles: centre and radius in x2.
+  // Text: position (or RA8876_DL_CONTINUE), then offset and length in the text buffer.
+  int16_t  x1;
+  int16_t  y1;
+  int16_t  x2;
+  int16_t  y2;
+};
+
+// Records drawing calls for replay with RA8876::drawList(), for screens that are
+//  redrawn the same way over and over. Text is recorded through print() like on the
+//  RA8876 itself.
+// Before replay the list is planned: operations entirely covered by a later opaque
+//  fillRect() or clearScreen() are dropped, and the rest are reordered, where they do
+//  not overlap, so that operations of the same kind and colour run together. That
+//  saves foreground colour writes and switches between text and graphics mode. Text
+//  extents are estimated from the font's widest character, and text is never reordered
+//  with respect to other text, as each piece may carry on from the cursor the last one
+//  left.
+class RA8876DisplayList : public Print
+{
+private:
+  DisplayOp m_ops[RA8876_DISPLAY_LIST_OPS];
+  int       m_count;
+  char      m_text[RA8876_DISPLAY_LIST_TEXT];
+  int       m_textLen;
+  bool      m_overflow;   // Something did not fit
+
+  // Recording state
+  uint16_t  m_textColor;
+  int16_t   m_cursorX;    // Position for the next text, or RA8876_DL_CONTINUE
+  int16_t   m_cursorY;
+  bool      m_textOpen;   // Further text can be appended to the last operation
+
+  // Replay plan, valid while m_planned is set and the geometry matches
+  uint8_t   m_order[RA8876_DISPLAY_LIST_OPS];
+  int       m_orderLen;
+  bool      m_planned;
+  int       m_planText[3];
+  DirtyRect m_planWindow;
+
+  DisplayOp *addOp(uint8_t type, uint16_t color);
+  void addShape(uint8_t type, int x1, int y1, int x2, int y2, uint16_t color);
+  void bounds(int i, int advance, int lineHeight, int overhang, const DirtyRect *window, DirtyRect *r) const;
+
+public:
+  RA8876DisplayList() { reset(); };
+
+  void reset(void);
+  int count(void) const { return m_count; };
+  bool overflowed(void) const { return m_overflow; };
+
+  // Recording, with the same meaning as the RA8876 calls
+  void drawLine(int x1, int y1, int x2, int y2, uint16_t color) { addShape(RA8876_OP_LINE, x1, y1, x2, y2, color); };
+  void drawRect(int x1, int y1, int x2, int y2, uint16_t color) { addShape(RA8876_OP_RECT, x1, y1, x2, y2, color); };
+  void fillRect(int x1, int y1, int x2, int y2, uint16_t color) { addShape(RA8876_OP_FILL_RECT, x1, y1, x2, y2, color); };
+  void drawCircle(int x, int y, int radius, uint16_t color) { addShape(RA8876_OP_CIRCLE, x, y, radius, 0, color); };
+  void fillCircle(int x, int y, int radius, uint16_t color) { addShape(RA8876_OP_FILL_CIRCLE, x, y, radius, 0, color); };
+  void clearScreen(uint16_t color);
+  void setCursor(int x, int y) { m_cursorX = x; m_cursorY = y; m_textOpen = false; };
+  void setTextColor(uint16_t color) { m_textColor = color; m_textOpen = false; };
+
+  // Internal for Print class
+  virtual size_t write(uint8_t c) { return write(&c, 1); };
+  virtual size_t write(const uint8_t *buffer, size_t size);
+
+  // Replay planning, done by RA8876::drawList(), for text where no character advances
+  //  the cursor more than advance or draws more than overhang outside its line, and for
+  //  the canvas window that drawing is clipped to and text wraps in. Returns the number
+  //  of operations to run.
+  int plan(int advance, int lineHeight, int overhang, const DirtyRect *window);
+  const DisplayOp *planOp(int i) const { return &m_ops[m_order[i]]; };
+  const char *text(const DisplayOp *op) const { return &m_text[op->x2]; };
+};
+
+#endif
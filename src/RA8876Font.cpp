@@ -0,0 +1,73 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Font.h"
+
+void RA8876FontAtlas::begin(const RA8876Font *font)
+{
+  m_font       = font;
+  m_maxAdvance = 0;
+  m_overhang   = 0;
+
+  for (uint32_t c = font->first; c <= font->last; c++)
+  {
+    RA8876Glyph g;
+    glyph(c, &g);
+
+    int top = font->baseline + g.yOffset;
+    m_maxAdvance = max(m_maxAdvance, max((int) g.xAdvance, g.xOffset + g.width));
+    m_overhang   = max(m_overhang, max(-g.xOffset, max(-top, top + g.height - font->yAdvance)));
+  }
+
+  // Kerning can move a glyph either way
+  int widest = 0;
+  for (int i = 0; font->kerning && (i < font->kernCount); i++)
+  {
+    int adjust = (int8_t) pgm_read_byte(&font->kerning[i].adjust);
+    widest     = max(widest, adjust);
+    m_overhang = max(m_overhang, -adjust);
+  }
+  m_maxAdvance += widest;
+}
+
+bool RA8876FontAtlas::glyph(uint32_t c, RA8876Glyph *g) const
+{
+  if (!m_font || (c < m_font->first) || (c > m_font->last))
+    return false;
+
+  const RA8876Glyph *p = &m_font->glyph[c - m_font->first];
+  g->bitmapOffset = pgm_read_dword(&p->bitmapOffset);
+  g->width        = pgm_read_byte(&p->width);
+  g->height       = pgm_read_byte(&p->height);
+  g->xAdvance     = pgm_read_byte(&p->xAdvance);
+  g->xOffset      = pgm_read_byte(&p->xOffset);
+  g->yOffset      = pgm_read_byte(&p->yOffset);
+
+  return true;
+}
+
+// Returns the cursor adjustment between two characters, by binary search of the
+//  kerning table.
+int RA8876FontAtlas::kerning(uint32_t left, uint32_t right) const
+{
+  if (!m_font || !m_font->kerning || (left > 0xFFFF) || (right > 0xFFFF))
+    return 0;
+
+  uint32_t key = (left << 16) | right;
+  int lo = 0;
+  int hi = m_font->kernCount - 1;
+
+  while (lo <= hi)
+  {
+    int mid = (lo + hi) / 2;
+    const RA8876KernPair *pair = &m_font->kerning[mid];
+    uint32_t k = ((uint32_t) pgm_read_word(&pair->left) << 16) | pgm_read_word(&pair->right);
+
+    if (k == key)
+      return (int8_t) pgm_read_byte(&pair->adjust);
+    else if (k < key)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_FONT_H
+#define RA8876_FONT_H
+
+#include <Arduino.h>
+
+#include "RA8876Sdram.h"
+
+// Most glyphs a bitmap font can have, which sizes RA8876FontAtlas.
+#ifndef RA8876_FONT_MAX_GLYPHS
+#define RA8876_FONT_MAX_GLYPHS 96
+#endif
+
+// Glyphs that RA8876::write() lays out before drawing them, so that each coverage
+//  level's colour is set once for the lot rather than once per glyph.
+#ifndef RA8876_FONT_RUN
+#define RA8876_FONT_RUN 16
+#endif
+
+// Widest the glyph atlas in SDRAM gets, in pixels of the canvas depth. Glyphs that
+//  don't fit in one band start another below it.
+#define RA8876_FONT_ATLAS_WIDTH 1024
+
+// One character of a bitmap font, laid out as in Adafruit GFX fonts.
+struct RA8876Glyph
+{
+  uint32_t bitmapOffset;  // Into RA8876Font::bitmap
+  uint8_t  width;         // Bitmap size
+  uint8_t  height;
+  uint8_t  xAdvance;      // Cursor movement
+  int8_t   xOffset;       // From the cursor to the bitmap's left edge
+  int8_t   yOffset;       // From the baseline to the bitmap's top edge (usually negative)
+};
+
+// Cursor adjustment between a pair of characters, e.g. -2 for "AV".
+struct RA8876KernPair
+{
+  uint16_t left;
+  uint16_t right;
+  int8_t   adjust;
+};
+
+// A font converted on the host. The bitmaps, glyphs and kerning pairs are PROGMEM; this
+//  descriptor is not. Pixels are bpp bits each, the most significant bits first, packed
+//  without padding from one row to the next. For anti-aliased fonts (2 or 4 bits) the
+//  value is the coverage, from 0 for background to all ones for foreground.
+struct RA8876Font
+{
+  const uint8_t        *bitmap;
+  const RA8876Glyph    *glyph;      // One per character from first to last
+  uint16_t              first;
+  uint16_t              last;
+  uint8_t               yAdvance;   // Line height
+  uint8_t               baseline;   // From the top of the line
+  uint8_t               bpp;        // 1, 2 or 4
+  const RA8876KernPair *kerning;    // Sorted by left then right, or 0 if none
+  uint16_t              kernCount;
+};
+
+// Where RA8876::loadFont() put a font's glyphs in SDRAM. Each coverage level of a glyph
+//  is a one-bit-per-pixel plane packed into pixels of the canvas depth, for the BTE to
+//  colour expand; 1bpp fonts have one plane per glyph. The planes of a glyph lie side
+//  by side, for the levels set in its mask, lowest first.
+class RA8876FontAtlas
+{
+public:
+  struct Placement
+  {
+    uint16_t x;       // Of the first plane, in pixels of the canvas depth
+    uint16_t y;
+    uint16_t levels;  // Bit n-1 set if the glyph has pixels of coverage n
+  };
+
+private:
+  const RA8876Font *m_font;
+  SdramSurface      m_surface;
+  Placement         m_placement[RA8876_FONT_MAX_GLYPHS];
+  int               m_maxAdvance;
+  int               m_overhang;
+
+public:
+  RA8876FontAtlas() { m_font = 0; m_surface.address = RA8876_SDRAM_NONE; m_maxAdvance = 0; m_overhang = 0; };
+
+  const RA8876Font *font(void) const { return m_font; };
+  const SdramSurface *surface(void) const { return &m_surface; };
+
+  // Copies out the glyph for a character, or returns false if the font lacks it.
+  bool glyph(uint32_t c, RA8876Glyph *g) const;
+  const Placement *placement(uint32_t c) const { return &m_placement[c - m_font->first]; };
+
+  // The furthest any character can move the cursor or reach to the right of it,
+  //  kerning included, and the furthest a glyph can reach outside its line on the other
+  //  sides. Text is bounded by these without laying it out.
+  int maxAdvance(void) const { return m_maxAdvance; };
+  int overhang(void) const { return m_overhang; };
+
+  // Set up by RA8876::loadFont() and RA8876::freeFont()
+  void begin(const RA8876Font *font);
+  void setSurface(const SdramSurface *surface) { m_surface = *surface; };
+  void end(void) { m_font = 0; m_surface.address = RA8876_SDRAM_NONE; };
+  Placement *placement(uint32_t c) { return &m_placement[c - m_font->first]; };
+
+  int kerning(uint32_t left, uint32_t right) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876GlyphCache.h"
+
+// Forgets every glyph if they were rendered in a different font. The font is
+//  identified by whatever value the caller derives from its settings.
+void RA8876GlyphCache::setFont(uint32_t font)
+{
+  if (font == m_font)
+    return;
+
+  clear();
+  m_font = font;
+}
+
+int RA8876GlyphCache::find(uint16_t code)
+{
+  for (int i = 0; i < m_count; i++)
+  {
+    if (m_slots[i].code == code)
+    {
+      m_slots[i].used = ++m_clock;
+      m_hits++;
+      return i;
+    }
+  }
+
+  m_misses++;
+  return -1;
+}
+
+int RA8876GlyphCache::insert(uint16_t code, int width)
+{
+  int slot;
+
+  if (m_count < RA8876_GLYPH_CACHE_SLOTS)
+  {
+    slot = m_count++;
+  }
+  else
+  {
+    slot = 0;
+    for (int i = 1; i < m_count; i++)
+    {
+      if (m_slots[i].used < m_slots[slot].used)
+        slot = i;
+    }
+  }
+
+  m_slots[slot].code  = code;
+  m_slots[slot].width = width;
+  m_slots[slot].used  = ++m_clock;
+
+  return slot;
+}
@@ -0,0 +1,61 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_GLYPH_CACHE_H
+#define RA8876_GLYPH_CACHE_H
+
+#include <Arduino.h>
+
+// Number of glyphs a cache holds. Each takes a 32x32 pixel cell of one-bit-per-pixel
+//  bitmap in SDRAM: 128 bytes.
+#ifndef RA8876_GLYPH_CACHE_SLOTS
+#define RA8876_GLYPH_CACHE_SLOTS 128
+#endif
+
+// Largest glyph cell, in pixels either way (a full-width 32-pixel character).
+#define RA8876_GLYPH_CELL 32
+
+// Keeps track of which font ROM characters have been copied into SDRAM, for
+//  RA8876::setGlyphCache(). The bitmaps themselves are in SDRAM; this only holds, for
+//  each slot, the character code, its width and when it was last drawn. When the
+//  cache is full the least recently drawn glyph makes way. Lookups are a linear scan,
+//  which is cheap next to a font ROM fetch.
+// The hit and miss counts are for sizing RA8876_GLYPH_CACHE_SLOTS to the text a
+//  program shows: a screen that keeps missing needs more slots.
+class RA8876GlyphCache
+{
+private:
+  struct Slot
+  {
+    uint16_t code;
+    uint8_t  width;
+    uint32_t used;   // m_clock when last drawn
+  };
+
+  Slot     m_slots[RA8876_GLYPH_CACHE_SLOTS];
+  int      m_count;
+  uint32_t m_clock;
+  uint32_t m_font;   // Font the glyphs are from
+
+  uint32_t m_hits;
+  uint32_t m_misses;
+
+public:
+  RA8876GlyphCache() { clear(); resetStats(); };
+
+  void clear(void) { m_count = 0; m_clock = 0; m_font = 0; };
+  void setFont(uint32_t font);
+
+  // Returns the slot holding the code, or -1, counting a hit or a miss.
+  int find(uint16_t code);
+  // Takes a slot for the code, evicting the least recently drawn glyph if need be.
+  int insert(uint16_t code, int width);
+
+  int width(int slot) const { return m_slots[slot].width; };
+  int count(void) const { return m_count; };
+
+  uint32_t hits(void) const { return m_hits; };
+  uint32_t misses(void) const { return m_misses; };
+  void resetStats(void) { m_hits = 0; m_misses = 0; };
+};
+
+#endif
@@ -0,0 +1,61 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Metrics.h"
+
+// These are the standard advance widths of the two faces (Arial shares Helvetica's
+//  metrics) in thousandths of an em, scaled to the cell height and rounded.
+
+const uint8_t ra8876ArialWidths[3][RA8876_METRICS_COUNT] PROGMEM =
+{
+  {  // 16px
+     4,  4,  6,  9,  9, 14, 11,  3,  5,  5,  6,  9,  4,  5,  4,  4,
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  4,  4,  9,  9,  9,  9,
+    16, 11, 11, 12, 12, 11, 10, 12, 12,  4,  8, 11,  9, 13, 12, 12,
+    11, 12, 12, 11, 10, 12, 11, 15, 11, 11, 10,  4,  4,  4,  8,  9,
+     5,  9,  9,  8,  9,  9,  4,  9,  9,  4,  4,  8,  4, 13,  9,  9,
+     9,  9,  5,  8,  4,  9,  8, 12,  8,  8,  8,  5,  4,  5,  9
+  },
+  {  // 24px
+     7,  7,  9, 13, 13, 21, 16,  5,  8,  8,  9, 14,  7,  8,  7,  7,
+    13, 13, 13, 13, 13, 13, 13, 13, 13, 13,  7,  7, 14, 14, 14, 13,
+    24, 16, 16, 17, 17, 16, 15, 19, 17,  7, 12, 16, 13, 20, 17, 19,
+    16, 19, 17, 16, 15, 17, 16, 23, 16, 16, 15,  7,  7,  7, 11, 13,
+     8, 13, 13, 12, 13, 13,  7, 13, 13,  5,  5, 12,  5, 20, 13, 13,
+    13, 13,  8, 12,  7, 13, 12, 17, 12, 12, 12,  8,  6,  8, 14
+  },
+  {  // 32px
+     9,  9, 11, 18, 18, 28, 21,  6, 11, 11, 12, 19,  9, 11,  9,  9,
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18,  9,  9, 19, 19, 19, 18,
+    32, 21, 21, 23, 23, 21, 20, 25, 23,  9, 16, 21, 18, 27, 23, 25,
+    21, 25, 23, 21, 20, 23, 21, 30, 21, 21, 20,  9,  9,  9, 15, 18,
+    11, 18, 18, 16, 18, 18,  9, 18, 18,  7,  7, 16,  7, 27, 18, 18,
+    18, 18, 11, 16,  9, 18, 16, 23, 16, 16, 16, 11,  8, 11, 19
+  }
+};
+
+const uint8_t ra8876TimesWidths[3][RA8876_METRICS_COUNT] PROGMEM =
+{
+  {  // 16px
+     4,  5,  7,  8,  8, 13, 12,  3,  5,  5,  8,  9,  4,  5,  4,  4,
+     8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  4,  4,  9,  9,  9,  7,
+    15, 12, 11, 11, 12, 10,  9, 12, 12,  5,  6, 12, 10, 14, 12, 12,
+     9, 12, 11,  9, 10, 12, 12, 15, 12, 12, 10,  5,  4,  5,  8,  8,
+     5,  7,  8,  7,  8,  7,  5,  8,  8,  4,  4,  8,  4, 12,  8,  8,
+     8,  8,  5,  6,  4,  8,  8, 12,  8,  8,  7,  8,  3,  8,  9
+  },
+  {  // 24px
+     6,  8, 10, 12, 12, 20, 19,  4,  8,  8, 12, 14,  6,  8,  6,  7,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  7,  7, 14, 14, 14, 11,
+    22, 17, 16, 16, 17, 15, 13, 17, 17,  8,  9, 17, 15, 21, 17, 17,
+    13, 17, 16, 13, 15, 17, 17, 23, 17, 17, 15,  8,  7,  8, 11, 12,
+     8, 11, 12, 11, 12, 11,  8, 12, 12,  7,  7, 12,  7, 19, 12, 12,
+    12, 12,  8,  9,  7, 12, 12, 17, 12, 12, 11, 12,  5, 12, 13
+  },
+  {  // 32px
+     8, 11, 13, 16, 16, 27, 25,  6, 11, 11, 16, 18,  8, 11,  8,  9,
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16,  9,  9, 18, 18, 18, 14,
+    29, 23, 21, 21, 23, 20, 18, 23, 23, 11, 12, 23, 20, 28, 23, 23,
+    18, 23, 21, 18, 20, 23, 23, 30, 23, 23, 20, 11,  9, 11, 15, 16,
+    11, 14, 16, 14, 16, 14, 11, 16, 16,  9,  9, 16,  9, 25, 16, 16,
+    16, 16, 11, 12,  9, 16, 16, 23, 16, 16, 14, 15,  6, 15, 17
+  }
+};
@@ -0,0 +1,19 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_METRICS_H
+#define RA8876_METRICS_H
+
+#include <Arduino.h>
+
+// Range of characters covered by the proportional width tables.
+#define RA8876_METRICS_FIRST 0x20
+#define RA8876_METRICS_LAST  0x7E
+#define RA8876_METRICS_COUNT (RA8876_METRICS_LAST - RA8876_METRICS_FIRST + 1)
+
+// Advance widths in pixels, at a text scale of 1, of the ASCII characters in the
+//  proportional external ROM families. Indexed by FontSize (16, 24 and 32 pixel
+//  cells), then by character code less RA8876_METRICS_FIRST. In PROGMEM.
+extern const uint8_t ra8876ArialWidths[3][RA8876_METRICS_COUNT];
+extern const uint8_t ra8876TimesWidths[3][RA8876_METRICS_COUNT];
+
+#endif
@@ -0,0 +1,169 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Sdram.h"
+
+void RA8876SdramAllocator::begin(uint32_t size)
+{
+  m_blocks[0].address = 0;
+  m_blocks[0].size    = size & ~((uint32_t) 0x3);
+  m_blocks[0].used    = false;
+
+  m_blockCount = 1;
+}
+
+void RA8876SdramAllocator::removeBlock(int i)
+{
+  for (; i < m_blockCount - 1; i++)
+    m_blocks[i] = m_blocks[i + 1];
+
+  m_blockCount--;
+}
+
+// Returns the address of a new block of at least size bytes, or RA8876_SDRAM_NONE.
+uint32_t RA8876SdramAllocator::alloc(uint32_t size)
+{
+  size = (size + 3) & ~((uint32_t) 0x3);
+  if (!size)
+    return RA8876_SDRAM_NONE;
+
+  for (int i = 0; i < m_blockCount; i++)
+  {
+    Block *b = &m_blocks[i];
+    if (b->used || (b->size < size))
+      continue;
+
+    if (b->size > size)
+    {
+      // Split, leaving the remainder free
+      if (m_blockCount == RA8876_SDRAM_MAX_BLOCKS)
+        return RA8876_SDRAM_NONE;  // Table full
+
+      for (int j = m_blockCount; j > i + 1; j--)
+        m_blocks[j] = m_blocks[j - 1];
+      m_blockCount++;
+
+      m_blocks[i + 1].address = b->address + size;
+      m_blocks[i + 1].size    = b->size - size;
+      m_blocks[i + 1].used    = false;
+
+      b->size = size;
+    }
+
+    b->used = true;
+    return b->address;
+  }
+
+  return RA8876_SDRAM_NONE;
+}
+
+// Grows or shrinks an allocated block where it is, taking space from or returning it to
+//  a free block that follows. Returns false, leaving the block alone, if that space is
+//  in use or too small.
+bool RA8876SdramAllocator::resize(uint32_t address, uint32_t size)
+{
+  size = (size + 3) & ~((uint32_t) 0x3);
+  if (!size)
+    return false;
+
+  int i;
+  for (i = 0; i < m_blockCount; i++)
+  {
+    if ((m_blocks[i].address == address) && m_blocks[i].used)
+      break;
+  }
+  if (i == m_blockCount)
+    return false;
+
+  Block *b = &m_blocks[i];
+  bool nextFree = (i + 1 < m_blockCount) && !m_blocks[i + 1].used;
+
+  if (size > b->size)
+  {
+    uint32_t extra = size - b->size;
+    if (!nextFree || (m_blocks[i + 1].size < extra))
+      return false;
+
+    if (m_blocks[i + 1].size == extra)
+    {
+      removeBlock(i + 1);
+    }
+    else
+    {
+      m_blocks[i + 1].address += extra;
+      m_blocks[i + 1].size    -= extra;
+    }
+  }
+  else if (size < b->size)
+  {
+    uint32_t spare = b->size - size;
+    if (nextFree)
+    {
+      m_blocks[i + 1].address -= spare;
+      m_blocks[i + 1].size    += spare;
+    }
+    else
+    {
+      if (m_blockCount == RA8876_SDRAM_MAX_BLOCKS)
+        return false;  // Table full
+
+      for (int j = m_blockCount; j > i + 1; j--)
+        m_blocks[j] = m_blocks[j - 1];
+      m_blockCount++;
+
+      m_blocks[i + 1].address = b->address + size;
+      m_blocks[i + 1].size    = spare;
+      m_blocks[i + 1].used    = false;
+    }
+  }
+
+  b->size = size;
+  return true;
+}
+
+void RA8876SdramAllocator::free(uint32_t address)
+{
+  for (int i = 0; i < m_blockCount; i++)
+  {
+    if ((m_blocks[i].address != address) || !m_blocks[i].used)
+      continue;
+
+    m_blocks[i].used = false;
+
+    // Merge with the following block, then the preceding one
+    if ((i + 1 < m_blockCount) && !m_blocks[i + 1].used)
+    {
+      m_blocks[i].size += m_blocks[i + 1].size;
+      removeBlock(i + 1);
+    }
+    if ((i > 0) && !m_blocks[i - 1].used)
+    {
+      m_blocks[i - 1].size += m_blocks[i].size;
+      removeBlock(i);
+    }
+
+    return;
+  }
+}
+
+uint32_t RA8876SdramAllocator::freeBytes(void)
+{
+  uint32_t total = 0;
+  for (int i = 0; i < m_blockCount; i++)
+  {
+    if (!m_blocks[i].used)
+      total += m_blocks[i].size;
+  }
+
+  return total;
+}
+
+uint32_t RA8876SdramAllocator::largestFree(void)
+{
+  uint32_t largest = 0;
+  for (int i = 0; i < m_blockCount; i++)
+  {
+    if (!m_blocks[i].used && (m_blocks[i].size > largest))
+      largest = m_blocks[i].size;
+  }
+
+  return largest;
+}
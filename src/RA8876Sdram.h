@@ -0,0 +1,57 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_SDRAM_H
+#define RA8876_SDRAM_H
+
+#include <Arduino.h>
+
+// Maximum number of blocks (allocated or free) tracked by the allocator.
+#define RA8876_SDRAM_MAX_BLOCKS 32
+
+// Returned by RA8876SdramAllocator::alloc() when there is no room.
+#define RA8876_SDRAM_NONE 0xFFFFFFFF
+
+// An offscreen image in SDRAM, in block addressing mode.
+struct SdramSurface
+{
+  uint32_t address;  // Start address, a multiple of 4
+  uint16_t width;    // Image width in pixels, a multiple of 4 (for setCanvasRegion(), bteCopy(), etc.)
+  uint16_t height;   // Height in pixels
+  uint32_t stride;   // Bytes from one row to the next
+  int      depth;    // Bits per pixel
+};
+
+// Hands out regions of display SDRAM. Blocks are kept in address order in a fixed
+//  table, free and allocated alike; allocation takes the first free block that fits
+//  and splits it, and freeing merges a block with free neighbours. All addresses and
+//  sizes are multiples of 4, as the canvas and BTE address registers require.
+class RA8876SdramAllocator
+{
+private:
+  struct Block
+  {
+    uint32_t address;
+    uint32_t size;
+    bool     used;
+  };
+
+  Block m_blocks[RA8876_SDRAM_MAX_BLOCKS];
+  int   m_blockCount;
+
+  void removeBlock(int i);
+
+public:
+  RA8876SdramAllocator() { m_blockCount = 0; };
+
+  // Starts over with size bytes, all free.
+  void begin(uint32_t size);
+
+  uint32_t alloc(uint32_t size);
+  bool resize(uint32_t address, uint32_t size);
+  void free(uint32_t address);
+
+  uint32_t freeBytes(void);
+  uint32_t largestFree(void);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Terminal.h"
+
+RA8876Terminal::RA8876Terminal(RA8876 *tft)
+{
+  m_tft = tft;
+  m_ring.address = RA8876_SDRAM_NONE;
+  m_screenHeight = 0;
+
+  m_color      = 0xFFFF;
+  m_background = 0x0000;
+
+  m_cellWidth  = 0;
+  m_lineHeight = 0;
+  m_columns    = 0;
+
+  m_top     = 0;
+  m_lineY   = 0;
+  m_column  = 0;
+  m_lineEnd = 0;
+}
+
+// Allocates the ring and makes it the canvas and the displayed image. The ring has to
+//  hold two screens and a line, so that the copy back to the top never lands on rows
+//  being shown.
+bool RA8876Terminal::begin(int height)
+{
+  if (m_ring.address != RA8876_SDRAM_NONE)
+    end();
+
+  int width = m_tft->getWidth();
+  m_screenHeight = m_tft->getHeight();
+
+  m_cellWidth  = m_tft->measureText("M", 1);
+  m_lineHeight = m_tft->getTextSizeY();
+  if ((m_cellWidth <= 0) || (m_lineHeight <= 0) || (m_lineHeight > m_screenHeight))
+    return false;
+
+  m_columns = width / m_cellWidth;
+
+  int least = 2 * m_screenHeight + m_lineHeight;
+  if (height == 0)
+    height = least;
+  else if (height < least)
+    return false;
+
+  if (height > 8191)
+    return false;  // Display offset limit
+
+  if (!m_tft->allocSurface(width, height, &m_ring))
+    return false;
+
+  m_tft->setCanvasRegion(m_ring.address, m_ring.width);
+  m_tft->setCanvasWindow(0, 0, m_ring.width, m_ring.height);
+  clear();
+  m_tft->setDisplayRegion(m_ring.address, m_ring.width);
+
+  return true;
+}
+
+// Shows the frame buffer again, with the whole screen as the canvas, and frees the ring.
+void RA8876Terminal::end(void)
+{
+  if (m_ring.address == RA8876_SDRAM_NONE)
+    return;
+
+  int width = m_tft->getWidth();
+
+  m_tft->setDisplayRegion(0, width);
+  m_tft->setDisplayOffset(0, 0);
+  m_tft->setCanvasRegion(0, width);
+  m_tft->setCanvasWindow(0, 0, width, m_tft->getHeight());
+
+  m_tft->freeSurface(&m_ring);
+  m_ring.address = RA8876_SDRAM_NONE;
+}
+
+// Blanks the screen and starts again from the top of the ring.
+void RA8876Terminal::clear(void)
+{
+  m_tft->fillRect(0, 0, m_ring.width - 1, m_ring.height - 1, m_background);
+
+  m_top     = 0;
+  m_lineY   = 0;
+  m_column  = 0;
+  m_lineEnd = 0;
+
+  m_tft->setDisplayOffset(0, 0);
+}
+
+// Moves down a line. On the last line of the screen the display scrolls instead: the
+//  rows about to come into view are cleared and the offset moves down, or at the end
+//  of the ring, everything but the top line is copied back to the start first.
+void RA8876Terminal::newLine(void)
+{
+  m_column  = 0;
+  m_lineEnd = 0;
+
+  if (m_lineY + 2 * m_lineHeight <= m_screenHeight)
+  {
+    m_lineY += m_lineHeight;
+    return;
+  }
+
+  int right = m_ring.width - 1;
+
+  if (m_top + m_screenHeight + m_lineHeight <= m_ring.height)
+  {
+    int y = m_top + m_screenHeight;
+    m_tft->fillRect(0, y, right, y + m_lineHeight - 1, m_background);
+    m_top += m_lineHeight;
+  }
+  else
+  {
+    int keep = m_screenHeight - m_lineHeight;
+    m_tft->bteCopy(m_ring.address, m_ring.width, 0, m_top + m_lineHeight,
+                   m_ring.address, m_ring.width, 0, 0, m_ring.width, keep);
+    m_tft->fillRect(0, keep, right, m_screenHeight - 1, m_background);
+    m_top = 0;
+  }
+
+  m_tft->setDisplayOffset(0, m_top);
+}
+
+// Draws in the terminal's colour at its own position, and puts the driver's text colour
+//  and cursor back afterwards.
+size_t RA8876Terminal::write(const uint8_t *buffer, size_t size)
+{
+  if (m_ring.address == RA8876_SDRAM_NONE)
+    return 0;
+
+  uint16_t color = m_tft->getTextColor();
+  int cursorX = m_tft->getCursorX();
+  int cursorY = m_tft->getCursorY();
+
+  m_tft->setTextColor(m_color);
+
+  size_t i = 0;
+  while (i < size)
+  {
+    uint8_t c = buffer[i];
+
+    if (c == '\n')
+    {
+      newLine();
+      i++;
+      continue;
+    }
+    else if (c == '\r')
+    {
+      m_column = 0;
+      i++;
+      continue;
+    }
+
+    // A full line only wraps once there is more to put on it
+    if (m_column >= m_columns)
+      newLine();
+
+    // Take as much as fits on the line, counting UTF-8 continuation bytes as no width
+    size_t start = i;
+    int    first = m_column;
+    while ((i < size) && (buffer[i] != '\n') && (buffer[i] != '\r'))
+    {
+      bool lead = ((buffer[i] & 0xC0) != 0x80);
+      if (lead && (m_column >= m_columns))
+        break;
+
+      if (lead)
+        m_column++;
+      i++;
+    }
+
+    int y = m_top + m_lineY;
+
+    // Text is drawn with a transparent background, so wipe anything being overwritten
+    if (first < m_lineEnd)
+    {
+      int last = min(m_column, m_lineEnd);
+      m_tft->fillRect(first * m_cellWidth, y, last * m_cellWidth - 1, y + m_lineHeight - 1, m_background);
+    }
+
+    m_tft->setCursor(first * m_cellWidth, y);
+    m_tft->write(buffer + start, i - start);
+
+    if (m_column > m_lineEnd)
+      m_lineEnd = m_column;
+  }
+
+  m_tft->setTextColor(color);
+  m_tft->setCursor(cursorX, cursorY);
+
+  return size;
+}
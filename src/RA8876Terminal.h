@@ -0,0 +1,57 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_TERMINAL_H
+#define RA8876_TERMINAL_H
+
+#include <Arduino.h>
+
+#include "RA8876.h"
+
+// A full-screen scrolling console, for serial-monitor style output. Text goes to an
+//  image in SDRAM a line more than twice the screen height, or taller, used as a ring:
+//  each new line is cleared just below the visible area and the display offset moves
+//  down one line to show it, so a scroll costs a strip fill and a few register writes.
+//  When the bottom of the image is reached, the visible lines are moved back to the top
+//  with one BTE copy (into rows not on show, so nothing tears) and the offset starts
+//  over.
+// The font must be fixed-width, and selected before begin(). Lines wrap at the last
+//  column; '\r' goes back to the start of the line, and text written over earlier
+//  text replaces it. While the terminal is running it is both the canvas and the
+//  displayed image, at the canvas depth, which must match the display depth.
+class RA8876Terminal : public Print
+{
+private:
+  RA8876      *m_tft;
+  SdramSurface m_ring;
+  int          m_screenHeight;
+
+  uint16_t m_color;
+  uint16_t m_background;
+
+  int m_cellWidth;
+  int m_lineHeight;
+  int m_columns;
+
+  int m_top;       // Ring row shown at the top of the screen
+  int m_lineY;     // Current line, relative to the top of the screen
+  int m_column;
+  int m_lineEnd;   // Columns of the current line written so far
+
+  void newLine(void);
+
+public:
+  RA8876Terminal(RA8876 *tft);
+
+  // Ring height in pixels, 0 for the least that will do.
+  bool begin(int height = 0);
+  void end(void);
+
+  void setColors(uint16_t color, uint16_t background) { m_color = color; m_background = background; };
+  void clear(void);
+
+  // Internal for Print class
+  virtual size_t write(uint8_t c) { return write(&c, 1); };
+  virtual size_t write(const uint8_t *buffer, size_t size);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876TextBox.h"
+
+RA8876TextBox::RA8876TextBox(RA8876 *tft, int x, int y, int width, int height)
+{
+  m_tft    = tft;
+  m_x      = x;
+  m_y      = y;
+  m_width  = width;
+  m_height = height;
+
+  m_color      = 0xFFFF;
+  m_background = 0x0000;
+
+  m_len   = 0;
+  m_drawn = 0;
+  m_lineY = 0;
+}
+
+// Fills the box with its background colour and starts again from the top.
+void RA8876TextBox::clear(void)
+{
+  m_tft->fillRect(m_x, m_y, m_x + m_width - 1, m_y + m_height - 1, m_background);
+
+  m_len   = 0;
+  m_drawn = 0;
+  m_lineY = 0;
+}
+
+// Brings the screen up to date with the first end bytes of the current line, drawing
+//  what is new or wiping what has moved on to the next line.
+void RA8876TextBox::drawLine(size_t end)
+{
+  int top = m_y + m_lineY;
+
+  if (end < m_drawn)
+  {
+    int x = m_x + m_tft->measureText(m_line, end);
+    m_tft->fillRect(x, top, m_x + m_width - 1, top + m_tft->getTextSizeY() - 1, m_background);
+  }
+  else if (end > m_drawn)
+  {
+    m_tft->setCursor(m_x + m_tft->measureText(m_line, m_drawn), top);
+    m_tft->write((const uint8_t *) m_line + m_drawn, end - m_drawn);
+  }
+
+  m_drawn = end;
+}
+
+// Moves down a line, scrolling the box if that would run off the bottom.
+void RA8876TextBox::newLine(void)
+{
+  int lineHeight = m_tft->getTextSizeY();
+
+  m_lineY += lineHeight;
+  if (m_lineY + lineHeight > m_height)
+  {
+    int dy = m_lineY + lineHeight - m_height;
+    m_tft->scrollRect(m_x, m_y, m_width, m_height, dy, m_background);
+    m_lineY -= dy;
+  }
+}
+
+// Breaks the current line wherever it no longer fits or has a newline, and draws what
+//  remains. A line that fills the buffer is broken regardless.
+void RA8876TextBox::layout(void)
+{
+  while (m_len)
+  {
+    size_t next;
+    size_t end = m_tft->fitText(m_line, m_len, m_width, &next);
+
+    if ((end == m_len) && (m_len < RA8876_TEXT_BOX_LINE))
+    {
+      drawLine(m_len);
+      return;
+    }
+
+    drawLine(end);
+    newLine();
+
+    memmove(m_line, m_line + next, m_len - next);
+    m_len  -= next;
+    m_drawn = 0;
+  }
+}
+
+// Draws in the box's own window, colour and cursor position, and puts the driver's
+//  back afterwards, so that other text output carries on as if the box wasn't there.
+size_t RA8876TextBox::write(const uint8_t *buffer, size_t size)
+{
+  uint16_t wx, wy, ww, wh;
+  m_tft->getCanvasWindow(&wx, &wy, &ww, &wh);
+  m_tft->setCanvasWindow(m_x, m_y, m_width, m_height);
+
+  uint16_t color = m_tft->getTextColor();
+  int cursorX = m_tft->getCursorX();
+  int cursorY = m_tft->getCursorY();
+
+  m_tft->setTextColor(m_color);
+
+  for (size_t i = 0; i < size; i++)
+  {
+    if (buffer[i] == '\r')
+      continue;  // Ignored
+
+    m_line[m_len++] = buffer[i];
+    if ((buffer[i] == '\n') || (m_len == RA8876_TEXT_BOX_LINE))
+      layout();
+  }
+
+  layout();
+
+  m_tft->setCanvasWindow(wx, wy, ww, wh);
+  m_tft->setTextColor(color);
+  m_tft->setCursor(cursorX, cursorY);
+
+  return size;
+}
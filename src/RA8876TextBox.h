@@ -0,0 +1,55 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_TEXT_BOX_H
+#define RA8876_TEXT_BOX_H
+
+#include <Arduino.h>
+
+#include "RA8876.h"
+
+// Longest line a text box holds before forcing a break, in bytes.
+#ifndef RA8876_TEXT_BOX_LINE
+#define RA8876_TEXT_BOX_LINE 160
+#endif
+
+// A rectangle of the canvas that text is printed into, e.g. a log pane. Text is wrapped
+//  at word boundaries using the current font's metrics, and drawing is clipped to the
+//  box by making it the canvas window for the duration. When the box is full its
+//  contents scroll up with a BTE copy and only the freed line is cleared, rather than
+//  everything being redrawn.
+// The line being written is kept, so that when a word turns out not to fit it can be
+//  wiped from the end of the line and drawn again at the start of the next. Text is
+//  drawn in the box's colours and the driver's current font; the driver's text colour,
+//  cursor and canvas window are left as they were.
+class RA8876TextBox : public Print
+{
+private:
+  RA8876  *m_tft;
+  int      m_x;
+  int      m_y;
+  int      m_width;
+  int      m_height;
+  uint16_t m_color;
+  uint16_t m_background;
+
+  char     m_line[RA8876_TEXT_BOX_LINE];  // Current line, of which m_drawn bytes are on screen
+  size_t   m_len;
+  size_t   m_drawn;
+  int      m_lineY;   // Top of the current line, relative to the box
+
+  void drawLine(size_t end);
+  void newLine(void);
+  void layout(void);
+
+public:
+  RA8876TextBox(RA8876 *tft, int x, int y, int width, int height);
+
+  void setColors(uint16_t color, uint16_t background) { m_color = color; m_background = background; };
+  void clear(void);
+
+  // Internal for Print class
+  virtual size_t write(uint8_t c) { return write(&c, 1); };
+  virtual size_t write(const uint8_t *buffer, size_t size);
+};
+
+#endif
@@ -0,0 +1,322 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Transport.h"
+
+//
+// SPI
+//
+
+RA8876SpiTransport::RA8876SpiTransport(int csPin, uint32_t speed)
+  : m_spiSettings(speed, MSBFIRST, SPI_MODE3)
+{
+  m_csPin = csPin;
+
+  m_burst       = true;
+  m_bufferLen   = 0;
+  m_frameType   = -1;
+  m_csAsserted  = false;
+  m_selectedReg = -1;
+}
+
+void RA8876SpiTransport::begin(void)
+{
+  // Set up chip select pin
+  pinMode(m_csPin, OUTPUT);
+  digitalWrite(m_csPin, HIGH);
+
+  SPI.begin();
+
+  m_selectedReg = -1;  // Chip may have been reset
+}
+
+// Sends whatever is buffered, leaving the frame open.
+void RA8876SpiTransport::drain(void)
+{
+  if (!m_csAsserted)
+  {
+    digitalWrite(m_csPin, LOW);
+    m_csAsserted = true;
+  }
+
+  SPI.transfer(m_buffer, m_bufferLen);
+  m_bufferLen = 0;
+}
+
+// Sends whatever is buffered and ends the frame.
+void RA8876SpiTransport::closeFrame(void)
+{
+  if (m_frameType < 0)
+    return;
+
+  if (m_bufferLen)
+    drain();
+
+  digitalWrite(m_csPin, HIGH);
+  m_csAsserted = false;
+  m_frameType  = -1;
+}
+
+// Appends one cycle to the open frame, starting a new frame if the cycle type differs.
+void RA8876SpiTransport::emit(uint8_t type, uint8_t x)
+{
+  if (m_frameType != type)
+  {
+    closeFrame();
+
+    m_buffer[m_bufferLen++] = type;
+    m_frameType = type;
+  }
+
+  m_buffer[m_bufferLen++] = x;
+
+  if (m_bufferLen == RA8876_SPI_BUFFER_SIZE)
+    drain();
+}
+
+// Starts a data write frame and sends its cycle type byte, leaving chip select asserted
+//  for the caller to send the payload directly.
+void RA8876SpiTransport::openDataFrame(void)
+{
+  closeFrame();
+
+  digitalWrite(m_csPin, LOW);
+  SPI.transfer(RA8876_DATA_WRITE);
+
+  m_csAsserted = true;
+  m_frameType  = RA8876_DATA_WRITE;
+}
+
+uint8_t RA8876SpiTransport::readCycle(uint8_t type)
+{
+  closeFrame();
+
+  uint8_t frame[2] = { type, 0 };
+
+  digitalWrite(m_csPin, LOW);
+  SPI.transfer(frame, 2);
+  digitalWrite(m_csPin, HIGH);
+
+  return frame[1];
+}
+
+void RA8876SpiTransport::writeCmd(uint8_t x)
+{
+  if (!m_burst)
+  {
+    digitalWrite(m_csPin, LOW);
+    SPI.transfer(RA8876_CMD_WRITE);
+    SPI.transfer(x);
+    digitalWrite(m_csPin, HIGH);
+    return;
+  }
+
+  if (m_selectedReg == x)
+    return;  // Already selected
+
+  m_selectedReg = x;
+  emit(RA8876_CMD_WRITE, x);
+}
+
+void RA8876SpiTransport::writeData(uint8_t x)
+{
+  if (!m_burst)
+  {
+    digitalWrite(m_csPin, LOW);
+    SPI.transfer(RA8876_DATA_WRITE);
+    SPI.transfer(x);
+    digitalWrite(m_csPin, HIGH);
+    return;
+  }
+
+  emit(RA8876_DATA_WRITE, x);
+}
+
+void RA8876SpiTransport::writeDataBlock(const uint8_t *buffer, size_t size)
+{
+  if (!m_burst)
+  {
+    RA8876Transport::writeDataBlock(buffer, size);
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++)
+    emit(RA8876_DATA_WRITE, buffer[i]);
+}
+
+uint8_t RA8876SpiTransport::readData(void)
+{
+  if (!m_burst)
+  {
+    digitalWrite(m_csPin, LOW);
+    SPI.transfer(RA8876_DATA_READ);
+    uint8_t x = SPI.transfer(0);
+    digitalWrite(m_csPin, HIGH);
+    return x;
+  }
+
+  return readCycle(RA8876_DATA_READ);
+}
+
+// Reads the special status register.
+// This register uses a special cycle type instead of having an address like other registers.
+// See data sheet section 19.1.
+uint8_t RA8876SpiTransport::readStatus(void)
+{
+  if (!m_burst)
+  {
+    digitalWrite(m_csPin, LOW);
+    SPI.transfer(RA8876_STATUS_READ);
+    uint8_t x = SPI.transfer(0);
+    digitalWrite(m_csPin, HIGH);
+    return x;
+  }
+
+  return readCycle(RA8876_STATUS_READ);
+}
+
+//
+// Parallel
+//
+
+RA8876ParallelTransport::RA8876ParallelTransport(enum ParallelBusMode mode, int width, const int *dataPins, int csPin, int a0Pin, int strobePin, int readPin)
+{
+  m_mode  = mode;
+  m_width = (width == 16) ? 16 : 8;
+
+  for (int i = 0; i < m_width; i++)
+    m_dataPins[i] = dataPins[i];
+
+  m_csPin     = csPin;
+  m_a0Pin     = a0Pin;
+  m_strobePin = strobePin;
+  m_readPin   = readPin;
+
+  m_dataOutput   = false;
+  m_transactions = 0;
+}
+
+void RA8876ParallelTransport::begin(void)
+{
+  pinMode(m_csPin, OUTPUT);
+  digitalWrite(m_csPin, HIGH);
+
+  pinMode(m_a0Pin, OUTPUT);
+  pinMode(m_strobePin, OUTPUT);
+  pinMode(m_readPin, OUTPUT);
+
+  if (m_mode == RA8876_BUS_8080)
+  {
+    digitalWrite(m_strobePin, HIGH);  // WR# idle
+    digitalWrite(m_readPin, HIGH);    // RD# idle
+  }
+  else
+  {
+    digitalWrite(m_strobePin, LOW);   // E idle
+    digitalWrite(m_readPin, LOW);     // R/W# write
+  }
+
+  setDataDirection(true);
+}
+
+// There is no per-cycle framing on a parallel bus, so chip select is held for the
+//  whole transaction. The driver nests transactions (e.g. write() moving the cursor on
+//  a newline), so only the outermost pair drives the pin; otherwise an inner
+//  endTransaction() would deselect the chip under the rest of the outer one.
+void RA8876ParallelTransport::beginTransaction(void)
+{
+  if (m_transactions++ == 0)
+    digitalWrite(m_csPin, LOW);
+}
+
+void RA8876ParallelTransport::endTransaction(void)
+{
+  if ((m_transactions > 0) && (--m_transactions == 0))
+    digitalWrite(m_csPin, HIGH);
+}
+
+void RA8876ParallelTransport::setDataDirection(bool output)
+{
+  for (int i = 0; i < m_width; i++)
+    pinMode(m_dataPins[i], output ? OUTPUT : INPUT);
+
+  m_dataOutput = output;
+}
+
+void RA8876ParallelTransport::busWrite(uint16_t x)
+{
+  for (int i = 0; i < m_width; i++)
+    digitalWrite(m_dataPins[i], (x >> i) & 1);
+}
+
+uint16_t RA8876ParallelTransport::busRead(void)
+{
+  uint16_t x = 0;
+  for (int i = 0; i < m_width; i++)
+    x |= (digitalRead(m_dataPins[i]) ? 1 : 0) << i;
+
+  return x;
+}
+
+void RA8876ParallelTransport::cycleWrite(bool a0, uint16_t x)
+{
+  if (!m_dataOutput)
+    setDataDirection(true);
+
+  digitalWrite(m_a0Pin, a0 ? HIGH : LOW);
+  busWrite(x);
+
+  if (m_mode == RA8876_BUS_8080)
+  {
+    // Data is latched on the rising edge of WR#
+    digitalWrite(m_strobePin, LOW);
+    digitalWrite(m_strobePin, HIGH);
+  }
+  else
+  {
+    // Data is latched on the falling edge of E
+    digitalWrite(m_readPin, LOW);
+    digitalWrite(m_strobePin, HIGH);
+    digitalWrite(m_strobePin, LOW);
+  }
+}
+
+uint16_t RA8876ParallelTransport::cycleRead(bool a0)
+{
+  if (m_dataOutput)
+    setDataDirection(false);
+
+  digitalWrite(m_a0Pin, a0 ? HIGH : LOW);
+
+  uint16_t x;
+  if (m_mode == RA8876_BUS_8080)
+  {
+    digitalWrite(m_readPin, LOW);
+    x = busRead();
+    digitalWrite(m_readPin, HIGH);
+  }
+  else
+  {
+    digitalWrite(m_readPin, HIGH);
+    digitalWrite(m_strobePin, HIGH);
+    x = busRead();
+    digitalWrite(m_strobePin, LOW);
+  }
+
+  return x;
+}
+
+// On a 16-bit bus a whole pixel goes in one cycle.
+void RA8876ParallelTransport::writeData16(uint16_t x)
+{
+  if (m_width == 16)
+    cycleWrite(true, x);
+  else
+    RA8876Transport::writeData16(x);
+}
+
+uint16_t RA8876ParallelTransport::readData16(void)
+{
+  if (m_width == 16)
+    return cycleRead(true);
+  else
+    return RA8876Transport::readData16();
+}
@@ -0,0 +1,201 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_TRANSPORT_H
+#define RA8876_TRANSPORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// 1MHz. TODO: Figure out actual speed to use
+// Data sheet section 5.2 says maximum SPI clock is 50MHz.
+#define RA8876_SPI_SPEED 1000000
+
+// With SPI, the RA8876 expects an initial byte where the top two bits are meaningful. Bit 7
+// is A0, bit 6 is WR#. See data sheet section 7.3.2 and section 19.
+// A0: 0 for command/status, 1 for data
+// WR#: 0 for write, 1 for read
+#define RA8876_DATA_WRITE  0x80
+#define RA8876_DATA_READ   0xC0
+#define RA8876_CMD_WRITE   0x00
+#define RA8876_STATUS_READ 0x40
+
+// Size of the SPI framing buffer. Longer runs of data are sent in pieces of this size
+//  without releasing chip select.
+#define RA8876_SPI_BUFFER_SIZE 32
+
+// Called when a background transfer completes. May be called from an interrupt.
+typedef void (*RA8876TransferCallback)(void *context);
+
+// Host bus interface to the RA8876. The chip has four cycle types: command (register
+//  address) write, data write, data read and status read. A transport implements
+//  them for one physical interface. See data sheet section 7.
+class RA8876Transport
+{
+public:
+  virtual ~RA8876Transport() {};
+
+  virtual void begin(void) = 0;
+
+  // Brackets a group of cycles, e.g. to claim a shared SPI bus.
+  virtual void beginTransaction(void) {};
+  virtual void endTransaction(void) {};
+
+  // Transports may hold back writes to batch them. This pushes out anything pending,
+  //  and must be called before any delay that the chip is expected to observe.
+  virtual void flush(void) {};
+
+  virtual void writeCmd(uint8_t x) = 0;
+  virtual void writeData(uint8_t x) = 0;
+  virtual uint8_t readData(void) = 0;
+  virtual uint8_t readStatus(void) = 0;
+
+  // True if the host data bus is 16 bits wide, in which case memory data writes
+  //  carry a whole 16-bit value per cycle.
+  virtual bool is16Bit(void) { return false; };
+
+  // Writes a 16-bit memory value, low byte first on 8-bit buses.
+  virtual void writeData16(uint16_t x) { writeData(x & 0xFF); writeData(x >> 8); };
+
+  // Reads a 16-bit memory value, low byte first on 8-bit buses.
+  virtual uint16_t readData16(void) { uint16_t x = readData(); return x | (readData() << 8); };
+
+  // Writes a run of data bytes to the currently selected register.
+  virtual void writeDataBlock(const uint8_t *buffer, size_t size)
+  {
+    for (size_t i = 0; i < size; i++)
+      writeData(buffer[i]);
+  };
+
+  // Starts writing a run of 16-bit memory values, as writeData16() would, and returns
+  //  without waiting if the transport can move them in the background (e.g. by DMA).
+  //  The buffer must be left alone until transferBusy() returns false, at which point
+  //  the callback (if any) has been called. No other cycles may be issued meanwhile.
+  // This default is synchronous.
+  virtual void writeData16Async(const uint16_t *data, size_t count, RA8876TransferCallback callback, void *context)
+  {
+    for (size_t i = 0; i < count; i++)
+      writeData16(data[i]);
+
+    if (callback)
+      callback(context);
+  };
+
+  // True while a transfer started by writeData16Async() is still running.
+  virtual bool transferBusy(void) { return false; };
+
+  // True if writeData16Async() can send data faster than the chip retires it from the
+  //  write FIFO (roughly one entry per SDRAM write, tens of nanoseconds), in which case
+  //  the driver splits transfers into FIFO-sized pieces and waits for the FIFO to empty
+  //  between them. A transport that never outruns the chip (SPI, or a bus driven
+  //  through GPIO) can leave this false and stream the whole buffer in one go.
+  virtual bool outrunsFifo(void) { return false; };
+};
+
+// 4-wire SPI (data sheet section 7.3.2).
+// The first byte after chip select falls gives the cycle type, and every following
+//  byte until chip select rises is another cycle of that type. In burst mode (the
+//  default) writes are assembled in a buffer so that consecutive data writes share
+//  one frame and go out through block SPI.transfer() calls, and reselecting the
+//  register that is already selected is skipped. Switching between command, data
+//  and status cycles still needs a new frame.
+// A register write is a command cycle then a data cycle, so a run of register writes
+//  (all that a shape primitive such as fillCircle() sends) still takes two frames
+//  per register either way: burst mode only saves on runs of data, such as pixels,
+//  text and repeated writes to one register.
+// With burst mode off, every cycle is a separate two-byte frame.
+// For DMA, derive a class that overrides writeData16Async() and transferBusy(): call
+//  openDataFrame(), then send the data bytes (low byte first, which is the in-memory
+//  order of a uint16_t on little-endian hosts) with the platform's DMA API. The frame
+//  is closed by the next cycle or endTransaction().
+class RA8876SpiTransport : public RA8876Transport
+{
+private:
+  int m_csPin;
+
+  SPISettings m_spiSettings;
+
+  bool    m_burst;
+  uint8_t m_buffer[RA8876_SPI_BUFFER_SIZE];
+  size_t  m_bufferLen;
+  int     m_frameType;   // Cycle type of the open frame, or -1 if none
+  bool    m_csAsserted;  // Part of the open frame has already gone out
+  int     m_selectedReg; // Register last selected by a command write, or -1 if unknown
+
+  void emit(uint8_t type, uint8_t x);
+  void drain(void);
+  uint8_t readCycle(uint8_t type);
+
+protected:
+  void openDataFrame(void);
+  void closeFrame(void);
+
+public:
+  RA8876SpiTransport(int csPin, uint32_t speed = RA8876_SPI_SPEED);
+
+  void setBurst(bool enabled) { closeFrame(); m_burst = enabled; m_selectedReg = -1; };
+
+  virtual void begin(void);
+  virtual void beginTransaction(void) { SPI.beginTransaction(m_spiSettings); };
+  virtual void endTransaction(void) { closeFrame(); SPI.endTransaction(); };
+  virtual void flush(void) { closeFrame(); };
+
+  virtual void writeCmd(uint8_t x);
+  virtual void writeData(uint8_t x);
+  virtual uint8_t readData(void);
+  virtual uint8_t readStatus(void);
+
+  virtual void writeDataBlock(const uint8_t *buffer, size_t size);
+};
+
+enum ParallelBusMode
+{
+  RA8876_BUS_8080,  // Intel 8080 style: separate WR# and RD# strobes
+  RA8876_BUS_6800   // Motorola 6800 style: R/W# level and E enable strobe
+};
+
+// 8- or 16-bit parallel host bus (data sheet sections 7.1 and 7.2). The bus type is
+//  strapped on the chip; the mode given here must match it.
+// For 8080 mode, strobePin is WR# and readPin is RD#.
+// For 6800 mode, strobePin is E and readPin is R/W#.
+// Pins are driven with digitalWrite(), which is portable but slow. For speed, derive
+//  a class that overrides busWrite() and busRead() with direct port access.
+class RA8876ParallelTransport : public RA8876Transport
+{
+private:
+  enum ParallelBusMode m_mode;
+  int m_width;           // 8 or 16
+  int m_dataPins[16];    // D0 first
+  int m_csPin;
+  int m_a0Pin;
+  int m_strobePin;
+  int m_readPin;
+  int m_transactions;    // Nesting depth of beginTransaction() calls
+
+  void cycleWrite(bool a0, uint16_t x);
+  uint16_t cycleRead(bool a0);
+
+protected:
+  bool m_dataOutput;    // Data pins are currently outputs
+
+  virtual void setDataDirection(bool output);
+  virtual void busWrite(uint16_t x);
+  virtual uint16_t busRead(void);
+
+public:
+  RA8876ParallelTransport(enum ParallelBusMode mode, int width, const int *dataPins, int csPin, int a0Pin, int strobePin, int readPin);
+
+  virtual void begin(void);
+  virtual void beginTransaction(void);
+  virtual void endTransaction(void);
+
+  virtual void writeCmd(uint8_t x) { cycleWrite(false, x); };
+  virtual void writeData(uint8_t x) { cycleWrite(true, x); };
+  virtual uint8_t readData(void) { return cycleRead(true) & 0xFF; };
+  virtual uint8_t readStatus(void) { return cycleRead(false) & 0xFF; };
+
+  virtual bool is16Bit(void) { return m_width == 16; };
+  virtual void writeData16(uint16_t x);
+  virtual uint16_t readData16(void);
+};
+
+#endif
@@ -0,0 +1,77 @@
+#pragma GCC diagnostic warning "-Wall"
+#include "RA8876Unicode.h"
+
+uint16_t ra8876UnicodeLookup(const UnicodeMapEntry *map, size_t count, uint16_t unicode)
+{
+  size_t lo = 0;
+  size_t hi = count;
+
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    uint16_t u = pgm_read_word(&map[mid].unicode);
+
+    if (u == unicode)
+      return pgm_read_word(&map[mid].code);
+    else if (u < unicode)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return 0;
+}
+
+int32_t RA8876Utf8Decoder::feed(uint8_t x)
+{
+  m_unread = false;
+
+  if (m_pending)
+  {
+    if ((x & 0xC0) == 0x80)
+    {
+      m_code = (m_code << 6) | (x & 0x3F);
+      if (--m_pending)
+        return RA8876_UTF8_PENDING;
+
+      // Reject overlong forms, surrogates and anything past the last code point
+      if ((m_code < m_min) || ((m_code >= 0xD800) && (m_code <= 0xDFFF)) || (m_code > 0x10FFFF))
+        return RA8876_UTF8_REPLACEMENT;
+
+      return m_code;
+    }
+
+    // Sequence cut short: replace it, and leave this byte to start the next one
+    m_pending = 0;
+    m_unread  = true;
+    return RA8876_UTF8_REPLACEMENT;
+  }
+
+  if (x < 0x80)
+    return x;
+
+  if ((x & 0xE0) == 0xC0)
+  {
+    m_code = x & 0x1F;
+    m_pending = 1;
+    m_min = 0x80;
+  }
+  else if ((x & 0xF0) == 0xE0)
+  {
+    m_code = x & 0x0F;
+    m_pending = 2;
+    m_min = 0x800;
+  }
+  else if ((x & 0xF8) == 0xF0)
+  {
+    m_code = x & 0x07;
+    m_pending = 3;
+    m_min = 0x10000;
+  }
+  else
+  {
+    return RA8876_UTF8_REPLACEMENT;  // Stray continuation byte or invalid lead
+  }
+
+  return RA8876_UTF8_PENDING;
+}
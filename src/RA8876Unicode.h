@@ -0,0 +1,57 @@
+#pragma GCC diagnostic warning "-Wall"
+
+#ifndef RA8876_UNICODE_H
+#define RA8876_UNICODE_H
+
+#include <Arduino.h>
+
+// Returned by RA8876Utf8Decoder::feed() while a sequence is incomplete.
+#define RA8876_UTF8_PENDING  (-1)
+
+// Stands in for malformed input.
+#define RA8876_UTF8_REPLACEMENT 0xFFFD
+
+// One entry of a table mapping Unicode to the two-byte codes of a font ROM encoding.
+//  Tables are sorted by Unicode value and kept in PROGMEM.
+struct UnicodeMapEntry
+{
+  uint16_t unicode;
+  uint16_t code;
+};
+
+// Tables for the font ROM encodings. Each is only linked in if referenced, e.g. by
+//  passing it to RA8876::setUnicodeMap().
+#define RA8876_GB2312_MAP_SIZE 7445
+#define RA8876_BIG5_MAP_SIZE   13706
+#define RA8876_JIS_MAP_SIZE    6879
+
+extern const UnicodeMapEntry ra8876Gb2312Map[RA8876_GB2312_MAP_SIZE];
+extern const UnicodeMapEntry ra8876Big5Map[RA8876_BIG5_MAP_SIZE];
+extern const UnicodeMapEntry ra8876JisMap[RA8876_JIS_MAP_SIZE];
+
+// Looks up a character in a PROGMEM table, returning 0 if it is not there.
+uint16_t ra8876UnicodeLookup(const UnicodeMapEntry *map, size_t count, uint16_t unicode);
+
+// Decodes UTF-8 a byte at a time, so that a sequence may be split between calls.
+class RA8876Utf8Decoder
+{
+private:
+  uint32_t m_code;
+  uint8_t  m_pending;  // Continuation bytes still expected
+  uint32_t m_min;      // Smallest code point the sequence may encode
+  bool     m_unread;   // The last byte fed was not used
+
+public:
+  RA8876Utf8Decoder() { reset(); };
+
+  void reset(void) { m_pending = 0; m_unread = false; };
+
+  // Returns the code point completed by this byte, or RA8876_UTF8_PENDING.
+  int32_t feed(uint8_t x);
+
+  // True if the last byte fed cut a sequence short. feed() returned the replacement
+  //  for the broken sequence, and the byte has to be fed again to start the next one.
+  bool unread(void) { return m_unread; };
+};
+
+#endif